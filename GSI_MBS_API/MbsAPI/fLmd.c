@@ -29,6 +29,7 @@
 #include <unistd.h>
 #include <pwd.h>
 #include <sys/timeb.h>
+#include <sys/mman.h>
 #ifndef fpos64_t
 #define fpos64_t fpos_t
 #endif
@@ -110,6 +111,8 @@ int clock_gettime(int clockid, struct timespec *tp)
 #endif
 
 #include "fLmd.h"
+#include "f_ut_blkrd.h"
+#include "f_ut_swap4.h"
 
 int32_t  fLmdWriteBuffer(sLmdControl *, char *, uint32_t);
 uint32_t fLmdCleanup(sLmdControl *);
@@ -119,6 +122,12 @@ uint32_t fLmdOffsetRead(sLmdControl *);
 uint32_t fLmdOffsetWrite(sLmdControl *);
 lmdoff_t fLmdOffsetGet(sLmdControl *, uint32_t);
 void     fLmdOffsetElements(sLmdControl *, uint32_t, uint32_t *, uint32_t *);
+void     fLmdSwapHead(sLmdControl *);
+uint32_t fLmdSwapElement(sMbsHeader *);
+void     fLmdMapAdvise(sLmdControl *);
+void     fLmdUnmap(sLmdControl *);
+
+#define LMD__MAP_AHEAD 0x800000 /* bytes announced with MADV_WILLNEED at once */
 #define OFFSET__ENTRIES 250000
 
 //===============================================================
@@ -355,7 +364,8 @@ uint32_t fLmdConnectMbs(sLmdControl *pLmdControl,
         fLmdCleanup(pLmdControl);
         return(LMD__FAILURE);
     }
-    stat=f_stc_read((int32_t *)&sMbs, sizeof(sMbsTransportInfo),pLmdControl->iTCP,3);
+    f_stc_epoll(pLmdControl->pTCP); // else read with select
+    stat=f_stc_recv(pLmdControl->pTCP,(int32_t *)&sMbs, sizeof(sMbsTransportInfo),3);
     if (stat != STC__SUCCESS) {
         printf ("fLmdConnectMbs: Error read info from %s \n",Nodename);
         fLmdCleanup(pLmdControl);
@@ -472,13 +482,14 @@ uint32_t fLmdGetMbsBuffer(
                pLmdControl->cFile,leftBytes,sizeof(sMbsBufferHeader));
         return(LMD__FAILURE);
     }
-    // send request buffer for stream server
-    if(pLmdControl->iPort == PORT__STREAM) {
-        memset(cRequest,0,sizeof(cRequest));
-        strcpy(cRequest, "GETEVT");
+    // send request buffer for stream server, unless it was sent with the previous buffer
+    memset(cRequest,0,sizeof(cRequest));
+    strcpy(cRequest, "GETEVT");
+    if((pLmdControl->iPort == PORT__STREAM) && (pLmdControl->iRequests == 0)) {
         iReturn=f_stc_write(cRequest,12,pLmdControl->iTCP);
+        pLmdControl->iRequests=1;
     }
-    iReturn=f_stc_read((int32_t *)pBuf,sizeof(sMbsBufferHeader),pLmdControl->iTCP,pLmdControl->iTcpTimeout);
+    iReturn=f_stc_recv(pLmdControl->pTCP,(int32_t *)pBuf,sizeof(sMbsBufferHeader),pLmdControl->iTcpTimeout);
     if(iReturn == STC__TIMEOUT) return(LMD__TIMEOUT);
     if(iReturn != STC__SUCCESS) return(LMD__FAILURE);
     if(pLmdControl->iSwap)fLmdSwap4((uint32_t *)pBuf,sizeof(sMbsBufferHeader)/4);
@@ -489,9 +500,17 @@ uint32_t fLmdGetMbsBuffer(
     }
     usedBytes=pBuf->iUsedWords*2;
     if((pBuf->iType&0xffff) == 100)
-        iReturn=f_stc_read((int32_t *)(pBuf+1),usedBytes,pLmdControl->iTCP,-1);
+        iReturn=f_stc_recv(pLmdControl->pTCP,(int32_t *)(pBuf+1),usedBytes,-1);
     if(iReturn == STC__TIMEOUT) return(LMD__TIMEOUT);
     if(iReturn != STC__SUCCESS) return(LMD__FAILURE);
+    // the next buffers are requested before this one is decoded
+    if(pLmdControl->iPort == PORT__STREAM) {
+        pLmdControl->iRequests--;
+        while(pLmdControl->iRequests < pLmdControl->iRequestDepth) {
+            if(f_stc_write(cRequest,12,pLmdControl->iTCP) != STC__SUCCESS) break; // the next read fails
+            pLmdControl->iRequests++;
+        }
+    }
     if(pLmdControl->iSwap)fLmdSwap4((uint32_t *)(pBuf+1),usedBytes/4);
     if(iBytesUsed != NULL)*iBytesUsed =usedBytes+sizeof(sMbsBufferHeader);
     if(iElements  != NULL)*iElements  =pBuf->iElements;
@@ -716,8 +735,30 @@ uint32_t fLmdGetElement(sLmdControl *pLmdControl, uint32_t iEvent, sMbsHeader **
 
     if(iEvent == LMD__NO_INDEX) {
         if(pLmdControl->pBuffer==NULL) return(GETLMD__NOBUFFER); // internal buffer needed
-        if(pLmdControl->pMbsFileHeader->iElements==0) return(GETLMD__NOMORE);
+        // a file still written has no element count in the header yet
+        if((pLmdControl->pMbsFileHeader->iElements==0) && !pLmdControl->iFollow) return(GETLMD__NOMORE);
+
+        if(pLmdControl->pMap != NULL) {
+            // complete events are returned in place, nothing is copied
+            if(pLmdControl->iMapPos+sizeof(sMbsHeader) <= pLmdControl->iMapBytes) {
+                pM = (sMbsHeader *)(pLmdControl->pMap+pLmdControl->iMapPos);
+                evsz = (pM->iWords + 4) * 2;
+                if(pLmdControl->iMapPos+evsz <= pLmdControl->iMapBytes) {
+                    pLmdControl->iMapPos += evsz;
+                    if(pLmdControl->iMapPos > pLmdControl->iMapAdvised) fLmdMapAdvise(pLmdControl);
+                    pLmdControl->pMbsFileHeader->iElements--;
+                    pLmdControl->iElements++;
+                    pLmdControl->iBytes += evsz;
+                    *event=pM;
+                    return(LMD__SUCCESS);
+                }
+            }
+            // end of the mapping, the file may have grown since: continue with stdio
+            fseeko(pLmdControl->fFile,pLmdControl->iMapPos,SEEK_SET);
+            fLmdUnmap(pLmdControl);
+        }
 
+        if(pLmdControl->iLazySwap) fLmdSwapHead(pLmdControl);
         // check if we need to read extra data
         if ((pLmdControl->iLeftWords < 4) ||
                 (pLmdControl->pMbsHeader == 0) ||
@@ -726,6 +767,7 @@ uint32_t fLmdGetElement(sLmdControl *pLmdControl, uint32_t iEvent, sMbsHeader **
             if (pLmdControl->iLeftWords > 0) {
                 memmove(pLmdControl->pBuffer, pLmdControl->pMbsHeader, pLmdControl->iLeftWords*2);
                 //                printf("copy to the begin rest %u bytes", pLmdControl->iLeftWords*2);
+                pLmdControl->pMbsHeader=(sMbsHeader *)pLmdControl->pBuffer; // the read below may return nothing
             }
 
             // second, try to read more bytes
@@ -734,15 +776,30 @@ uint32_t fLmdGetElement(sLmdControl *pLmdControl, uint32_t iEvent, sMbsHeader **
                                      (char *)(pLmdControl->pBuffer+pLmdControl->iLeftWords),
                                      (pLmdControl->iBufferWords-pLmdControl->iLeftWords)*2);
 
-            if(iReturn <= 0) { printf("fLmdGetElement: EOF\n"); return(GETLMD__EOFILE); }
+            // followed file: whole words only, the rest is read again with the next call
+            if(pLmdControl->iFollow && (iReturn > 0) && (iReturn & 3) && (pLmdControl->pBlkrd == NULL)){
+                fseeko(pLmdControl->fFile,-(iReturn & 3),SEEK_CUR);
+                iReturn -= iReturn & 3;
+            }
+            if(iReturn <= 0) {
+                if(!pLmdControl->iFollow) printf("fLmdGetElement: EOF\n");
+                return(GETLMD__EOFILE);
+            }
 
-            if(pLmdControl->iSwap) fLmdSwap4((uint32_t *)(pLmdControl->pBuffer+pLmdControl->iLeftWords),iReturn/4);
+            if(pLmdControl->iSwap && !pLmdControl->iLazySwap)
+                fLmdSwap4((uint32_t *)(pLmdControl->pBuffer+pLmdControl->iLeftWords),iReturn/4);
 
             pLmdControl->iBytes += iReturn;
             pLmdControl->pMbsHeader=(sMbsHeader *)pLmdControl->pBuffer;
             pLmdControl->iLeftWords += iReturn/2;
+            if(pLmdControl->iLazySwap) fLmdSwapHead(pLmdControl);
         }
 
+        // followed file: the rest of the element is not written yet, it stays in the buffer
+        if(pLmdControl->iFollow && (pLmdControl->iLeftWords < pLmdControl->iBufferWords) &&
+           ((pLmdControl->iLeftWords < 4) || (pLmdControl->pMbsHeader->iWords+4 > pLmdControl->iLeftWords)))
+            return(GETLMD__EOFILE);
+
         // check if read buffer enough for event
 
         evsz = (pLmdControl->pMbsHeader->iWords + 4) * 2;
@@ -758,6 +815,11 @@ uint32_t fLmdGetElement(sLmdControl *pLmdControl, uint32_t iEvent, sMbsHeader **
         pLmdControl->pMbsHeader = (sMbsHeader *) ((char*) pM + evsz);
         pLmdControl->iLeftWords -= evsz/2;
         pLmdControl->iElements++;
+        pLmdControl->iEventSwap=0;
+        if(pLmdControl->iSwap && pLmdControl->iLazySwap){
+            pLmdControl->iEventSwap=fLmdSwapElement(pM);
+            pLmdControl->iHeadSwapped=0; // next header is swapped with the next call
+        }
         *event=pM;
         return(LMD__SUCCESS);
     }
@@ -780,6 +842,7 @@ uint32_t fLmdGetElement(sLmdControl *pLmdControl, uint32_t iEvent, sMbsHeader **
             return(GETLMD__SIZE_ERROR);
         }
         pLmdControl->iBytes+=iReturn;
+        pLmdControl->iEventSwap=0;
         *event=pLmdControl->pMbsHeader;
         return(LMD__SUCCESS);
     }
@@ -799,7 +862,28 @@ uint32_t fLmdGetClose(sLmdControl *pLmdControl)
 }
 //===============================================================
 int32_t fLmdReadBuffer(sLmdControl *pLmdControl, char *buffer, uint32_t bytes){
-    int32_t IObytes;
+    int32_t IObytes, iRead;
+    uint32_t n;
+    if(pLmdControl->pBlkrd != NULL){
+        // copy from the blocks read ahead
+        IObytes=0;
+        while((uint32_t)IObytes < bytes){
+            if(pLmdControl->iBlockPos == pLmdControl->iBlockBytes){
+                iRead=f_ut_blkrd_get((s_blkrd *)pLmdControl->pBlkrd,pLmdControl->iReadPos,&pLmdControl->pBlock);
+                if(iRead <= 0) break;
+                pLmdControl->iBlockBytes=iRead;
+                pLmdControl->iBlockPos=0;
+                pLmdControl->iReadPos+=iRead;
+            }
+            n=pLmdControl->iBlockBytes-pLmdControl->iBlockPos;
+            if(n > bytes-IObytes) n=bytes-IObytes;
+            memcpy(buffer+IObytes,pLmdControl->pBlock+pLmdControl->iBlockPos,n);
+            pLmdControl->iBlockPos+=n;
+            IObytes+=n;
+        }
+        return(IObytes);
+    }
+    if(pLmdControl->iFollow) clearerr(pLmdControl->fFile); // the file may have grown since the last end of file
     IObytes=(int32_t)fread(buffer,1,bytes,pLmdControl->fFile);
     //if(IObytes < bytes) printf("Read %s: request %d bytes, got %d\n",pLmdControl->cFile,bytes,IObytes);
     return(IObytes);
@@ -813,6 +897,177 @@ int32_t fLmdWriteBuffer(sLmdControl *pLmdControl, char *buffer, uint32_t bytes){
     return(IObytes);
 }
 //===============================================================
+//===============================================================
+// map the file, fLmdGetElement(LMD__NO_INDEX) returns the events as pointers into the mapping.
+// they stay valid until fLmdGetClose. must be called after fLmdGetOpen.
+// files with other endian are read with stdio, the events must be swapped anyway.
+uint32_t fLmdGetMap(sLmdControl *pLmdControl){
+#ifdef Linux
+    struct stat sStat;
+    void *pMap;
+    off_t iPos;
+    int iFd;
+
+    if((pLmdControl->fFile == NULL) || (pLmdControl->iSwap) || (pLmdControl->pMap != NULL))
+        return(LMD__FAILURE);
+    iFd = fileno(pLmdControl->fFile);
+    iPos = ftello(pLmdControl->fFile);
+    if((fstat(iFd,&sStat) != 0) || (iPos < 0) || (iPos >= sStat.st_size))
+        return(LMD__FAILURE);
+
+    pMap = mmap(NULL,sStat.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,iFd,0);
+    if(pMap == MAP_FAILED){
+        printf("fLmdGetMap: %s can not be mapped, use read\n",pLmdControl->cFile);
+        return(LMD__FAILURE);
+    }
+    madvise(pMap,sStat.st_size,MADV_SEQUENTIAL);
+
+    pLmdControl->pMap=(char *)pMap;
+    pLmdControl->iMapBytes=sStat.st_size;
+    pLmdControl->iMapPos=iPos;
+    pLmdControl->iMapAdvised=iPos;
+    fLmdMapAdvise(pLmdControl);
+    return(LMD__SUCCESS);
+#else
+    return(LMD__FAILURE);
+#endif
+}
+//===============================================================
+// announce the next LMD__MAP_AHEAD bytes behind the current position
+void fLmdMapAdvise(sLmdControl *pLmdControl){
+#ifdef Linux
+    lmdoff_t iBegin, iEnd;
+    iBegin = pLmdControl->iMapPos & ~((lmdoff_t)sysconf(_SC_PAGESIZE)-1);
+    iEnd = pLmdControl->iMapPos + LMD__MAP_AHEAD;
+    if(iEnd > pLmdControl->iMapBytes) iEnd = pLmdControl->iMapBytes;
+    if(iEnd > iBegin) madvise(pLmdControl->pMap+iBegin,iEnd-iBegin,MADV_WILLNEED);
+    pLmdControl->iMapAdvised = iBegin + LMD__MAP_AHEAD/2; // next call in the middle of the range
+#endif
+}
+//===============================================================
+void fLmdUnmap(sLmdControl *pLmdControl){
+#ifdef Linux
+    if(pLmdControl->pMap != NULL) munmap(pLmdControl->pMap,pLmdControl->iMapBytes);
+#endif
+    pLmdControl->pMap=NULL;
+    pLmdControl->iMapBytes=0;
+    pLmdControl->iMapPos=0;
+    pLmdControl->iMapAdvised=0;
+}
+//===============================================================
+// read the rest of the file in blocks of iBlockBytes (0: internal buffer size), iDepth blocks ahead,
+// with io_uring if iUring is 1 and available. must be called after fLmdGetOpen, not with an offset table.
+uint32_t fLmdSetReadAhead(sLmdControl *pLmdControl, uint32_t iBlockBytes, uint32_t iDepth, uint32_t iUring){
+    off_t iPos;
+
+    if((pLmdControl->fFile == NULL) || (pLmdControl->pBlkrd != NULL) || (pLmdControl->pMap != NULL) ||
+       (pLmdControl->iOffsetEntries > 0) || (iDepth == 0))
+        return(LMD__FAILURE);
+    if(iBlockBytes == 0) iBlockBytes = pLmdControl->iBufferWords*2;
+    iPos = ftello(pLmdControl->fFile);
+    if(iPos < 0) return(LMD__FAILURE);
+
+    pLmdControl->pBlkrd = f_ut_blkrd_open(fileno(pLmdControl->fFile),iBlockBytes,iDepth,iUring,iPos);
+    if(pLmdControl->pBlkrd == NULL){
+        printf("fLmdSetReadAhead: no read-ahead for %s\n",pLmdControl->cFile);
+        return(LMD__FAILURE);
+    }
+    if((iUring == 1) && (f_ut_blkrd_uring((s_blkrd *)pLmdControl->pBlkrd) == 0))
+        printf("fLmdSetReadAhead: io_uring not available, read %s with pread\n",pLmdControl->cFile);
+    pLmdControl->pBlock=NULL;
+    pLmdControl->iBlockBytes=0;
+    pLmdControl->iBlockPos=0;
+    pLmdControl->iReadPos=iPos;
+    return(LMD__SUCCESS);
+}
+//===============================================================
+// with iOn=1 fLmdGetElement(LMD__NO_INDEX) swaps only the element header, the event header and the
+// subevent headers of events in other endian. iEventSwap tells whether the subevent data of the
+// returned event is still in other endian, see fLmdSwapSubeventData. Other elements and events with
+// irregular subevents are swapped completely. must be called after fLmdGetOpen, not with fLmdGetBuffer.
+void fLmdSetLazySwap(sLmdControl *pLmdControl, uint32_t iOn){
+    pLmdControl->iLazySwap=iOn;
+}
+//===============================================================
+// with iOn=1 the file is still written: fLmdGetElement(LMD__NO_INDEX) ignores the element count of the
+// file header and returns GETLMD__EOFILE for an element that is not complete yet. the next call continues
+// with this element. must be called after fLmdGetOpen, not with fLmdSetReadAhead.
+void fLmdSetFollow(sLmdControl *pLmdControl, uint32_t iOn){
+    pLmdControl->iFollow=iOn;
+}
+//===============================================================
+// fLmdGetMbsBuffer from a stream server sends the requests for the next iDepth buffers as soon as a
+// buffer is read, they are answered while this buffer is decoded. 0: one request per buffer (default).
+// must be called after fLmdConnectMbs/fLmdInitMbs.
+void fLmdSetRequestDepth(sLmdControl *pLmdControl, uint32_t iDepth){
+    pLmdControl->iRequestDepth=iDepth;
+}
+//===============================================================
+// swap the header at pMbsHeader, if it is complete and not yet swapped
+void fLmdSwapHead(sLmdControl *pLmdControl){
+    if(pLmdControl->iSwap && !pLmdControl->iHeadSwapped &&
+       (pLmdControl->pMbsHeader != NULL) && (pLmdControl->iLeftWords >= 4)){
+        fLmdSwap4((uint32_t *)pLmdControl->pMbsHeader,2);
+        pLmdControl->iHeadSwapped=1;
+    }
+}
+//===============================================================
+// the header of the element is swapped. returns 1 if only the headers of an event 10/1 were swapped,
+// 0 if the element was swapped completely.
+uint32_t fLmdSwapElement(sMbsHeader *pM){
+    if((pM->iType == LMD__TYPE_EVENT_HEADER_10_1) && (pM->iWords >= 4)){
+        fLmdSwap4((uint32_t *)(pM+1),2);
+        if(fLmdSwapSubeventHeaders((sMbsEventHeader *)pM)) return(1);
+        fLmdSwap4((uint32_t *)pM+4,(pM->iWords-4)/2);
+        return(0);
+    }
+    fLmdSwap4((uint32_t *)(pM+1),pM->iWords/2);
+    return(0);
+}
+//===============================================================
+// the event header is already swapped, the subevents are not. if all subevents fit exactly into the
+// event, their headers are swapped and 1 is returned. otherwise nothing is changed and 0 is returned.
+uint32_t fLmdSwapSubeventHeaders(sMbsEventHeader *pEvent){
+    uint32_t *pSub, iLeft, iWords;
+
+    if(pEvent->iWords < 4) return(0);
+    // check all subevents before anything is swapped
+    iLeft = pEvent->iWords-4; // 16 bit words
+    pSub = (uint32_t *)(pEvent+1);
+    while(iLeft > 0){
+        if(iLeft < sizeof(sMbsSubeventHeader)/2) return(0);
+        iWords = pSub[0];
+        fLmdSwap4(&iWords,1);
+        if((iWords < 2) || (iWords & 1) || (iWords+4 > iLeft)) return(0);
+        iLeft -= iWords+4;
+        pSub += (iWords+4)/2;
+    }
+    iLeft = pEvent->iWords-4;
+    pSub = (uint32_t *)(pEvent+1);
+    while(iLeft > 0){
+        fLmdSwap4(pSub,sizeof(sMbsSubeventHeader)/4);
+        iLeft -= pSub[0]+4;
+        pSub += (pSub[0]+4)/2;
+    }
+    return(1);
+}
+//===============================================================
+// swap the data of all subevents after fLmdSwapSubeventHeaders returned 1
+void fLmdSwapSubeventData(sMbsEventHeader *pEvent){
+    sMbsSubeventHeader *pSub;
+    uint32_t iLeft;
+
+    if(pEvent->iWords < 4) return;
+    iLeft = pEvent->iWords-4;
+    pSub = (sMbsSubeventHeader *)(pEvent+1);
+    while(iLeft >= sizeof(sMbsSubeventHeader)/2){
+        if((pSub->iWords < 2) || (pSub->iWords+4 > iLeft)) return;
+        fLmdSwap4((uint32_t *)(pSub+1),pSub->iWords/2-1);
+        iLeft -= pSub->iWords+4;
+        pSub = (sMbsSubeventHeader *)((uint32_t *)pSub+(pSub->iWords+4)/2);
+    }
+}
+//===============================================================
 uint64_t fLmdGetBytesWritten(sLmdControl *pLmdControl){
     uint64_t bytes;
     bytes=pLmdControl->iBytes;
@@ -828,6 +1083,10 @@ uint64_t fLmdGetBytesWritten(sLmdControl *pLmdControl){
 uint32_t fLmdCleanup(sLmdControl *pLmdControl)
 {
     // do not clean fFile
+    fLmdUnmap(pLmdControl);
+    if(pLmdControl->pBlkrd   != NULL)f_ut_blkrd_close((s_blkrd *)pLmdControl->pBlkrd);
+    pLmdControl->pBlkrd=NULL;
+    pLmdControl->pBlock=NULL;
     if(pLmdControl->pTCP     != NULL)free(pLmdControl->pTCP);
     if(pLmdControl->cHeader  != NULL)free(pLmdControl->cHeader);
     if(pLmdControl->pOffset4 != NULL)free(pLmdControl->pOffset4);
@@ -1116,18 +1375,8 @@ void fLmdPrintControl(uint32_t iVerbose, sLmdControl *pLmdControl)
     }}
 //===============================================================
 void fLmdSwap4(uint32_t *array, uint32_t items){
-    uint32_t i, *pp;
-    pp=array;
-    for(i=0;i<items;i++){
-        //printf("Swap 4 %08x ",*pp);
-        *pp =
-                (*pp >> 24) +
-                ((*pp >>  8)&0x0000ff00) +
-                ((*pp <<  8)&0x00ff0000) +
-                (*pp << 24);
-        //printf("to %08x \n",*pp);
-        pp++;
-    }}
+    f_ut_swap4(array,items,NULL);
+}
 //===============================================================
 void fLmdSwap8(uint64_t *array, uint32_t items){
     uint64_t *pp;
@@ -67,6 +67,21 @@ typedef struct
   uint32_t iPort;
   uint32_t iTcpTimeout;
   uint32_t iTCPowner;
+  char     *pMap;         /* mapping of the whole file, set by fLmdGetMap */
+  lmdoff_t iMapBytes;     /* size of the mapping */
+  lmdoff_t iMapPos;       /* position of the next event in the mapping */
+  lmdoff_t iMapAdvised;   /* end of the range announced with MADV_WILLNEED */
+  void     *pBlkrd;       /* block reader, set by fLmdSetReadAhead */
+  char     *pBlock;       /* current block of the reader */
+  uint32_t iBlockBytes;   /* bytes in pBlock */
+  uint32_t iBlockPos;     /* bytes of pBlock already read */
+  lmdoff_t iReadPos;      /* file offset behind pBlock */
+  uint32_t iLazySwap;     /* fLmdGetElement swaps headers only, see fLmdSetLazySwap */
+  uint32_t iHeadSwapped;  /* header at pMbsHeader already swapped */
+  uint32_t iEventSwap;    /* subevent data of the last element still to be swapped */
+  uint32_t iFollow;       /* file is still written, see fLmdSetFollow */
+  uint32_t iRequestDepth; /* requests outstanding while a buffer is decoded, see fLmdSetRequestDepth */
+  uint32_t iRequests;     /* requests sent whose buffer is not read yet */
 } sLmdControl;
 
 sLmdControl * fLmdAllocateControl();
@@ -92,6 +107,13 @@ void       fLmdPrintHeader(uint32_t,sMbsHeader*);
 void       fLmdPrintEvent(uint32_t,sMbsEventHeader*);
 void       fLmdPrintControl(uint32_t,sLmdControl*);
 void       fLmdVerbose(sLmdControl*,uint32_t);
+uint32_t   fLmdGetMap(sLmdControl*);
+uint32_t   fLmdSetReadAhead(sLmdControl*,uint32_t,uint32_t,uint32_t);
+void       fLmdSetLazySwap(sLmdControl*,uint32_t);
+void       fLmdSetFollow(sLmdControl*,uint32_t);
+void       fLmdSetRequestDepth(sLmdControl*,uint32_t);
+uint32_t   fLmdSwapSubeventHeaders(sMbsEventHeader*);
+void       fLmdSwapSubeventData(sMbsEventHeader*);
 void       fLmdSwap4(uint32_t*,uint32_t);
 void       fLmdSwap8(uint64_t*,uint32_t);
 void       fLmdSetWrittenEndian(sLmdControl *,uint32_t);
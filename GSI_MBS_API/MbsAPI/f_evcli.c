@@ -155,12 +155,9 @@
 void f_clnup(long [], int *);
 void f_clnup_save(long [], int *);
 int f_fltdscr(struct s_clnt_filter *);
-int f_read_server(s_evt_channel *, int *, int, int);
-int f_send_ackn(int, int);
+int f_read_server(s_evt_channel *, int *, int);
+int f_send_ackn(s_evt_channel *, int);
 
-unsigned short *pi_inbuf;
-unsigned int *pl_inbuf;
-unsigned int l_len_w;
 int swapw(unsigned short *, unsigned short *, unsigned int);
 int swapl(unsigned int *, unsigned int *, unsigned int);
 static int i_debug = 0;                  /* message level (0-3) */
@@ -170,31 +167,36 @@ static int i_debug = 0;                  /* message level (0-3) */
 #define FLUSH__TIME 3                    /* flush time interval for MBS event server */
 #define STDOUT_BUFIO_ 1
 
-  struct s_clnt_filter  *p_clnt_filter;
-  struct s_clntbuf      *p_clntbuf;
-  struct s_opc1         *p_opc1;
-
-  static int unsigned  lf_swap = 0;                  /* save swap on RX     */
-  static int unsigned  l_endian_serv;                /* save endian server  */
-  static int           l_len_lw1 = CLNT__BUFH_LW;    /* len for first swap  */
-  int                  l_len_lw2;                    /* len for 2nd   swap  */
-  int                   i_channel;                    /* TCP/IP channel      */
-  int unsigned         l_clnt_sts;                   /* status for ackn.    */
-  int         l_status, l_sts;
   static char           c_modnam[] = "f_evcli";
-  short         if_typevt, i_sign = 1, i_len;
-  int                  l_timeout;
-  int         l_retval;
-  static struct s_tcpcomm s_tcpcomm_ec = {0,0,0};
-static struct
-{
-   int                l_ack_buf;          /* read client buff received  */
-   int                l_ack_bytes;        /* read client bytes received */
-   int unsigned       l_clnt_sts;         /* client sts 1:o.k. 8:lst buf*/
-}  s_ackn;
 
+/* the state of one connection, ps_chan->p_evcli. Several channels can be */
+/* connected at the same time, also from different threads.               */
+typedef struct
+{
+  struct s_tcpcomm     s_tcpcomm_ec;
+  struct
+  {
+     int                l_ack_buf;          /* read client buff received  */
+     int                l_ack_bytes;        /* read client bytes received */
+     int unsigned       l_clnt_sts;         /* client sts 1:o.k. 8:lst buf*/
+  }  s_ackn;
+  int unsigned         lf_swap;             /* save swap on RX     */
+  int unsigned         l_endian_serv;       /* save endian server  */
+  int                  l_closed;            /* socket closed after an error */
   /* ++ vectors of pointer and devices for cleanup */
-  long          v_mem_clnup[8];
+  long                 v_mem_clnup[8];
+} s_evcli;
+
+/* release the connection state after a failed f_evcli_con */
+static void f_evcli_free(s_evt_channel *ps_chan)
+{
+  s_evcli *ps_evcli = (s_evcli *) ps_chan->p_evcli;
+
+  f_clnup(ps_evcli->v_mem_clnup, NULL);
+  free(ps_evcli);
+  ps_chan->p_evcli = NULL;
+}
+
 /***************************************************************************/
 int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_aevents, int l_asample)
 /***************************************************************************/
@@ -202,8 +204,23 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
   short                i_h, i_m, i_s;
   char                  c_node[32], c_retmsg[256];
   int                  l_port;
+  int                   i_channel;                    /* TCP/IP channel      */
+  int                  l_len_lw2;                    /* len for 2nd   swap  */
+  int         l_status, l_retval;
+  struct s_clnt_filter  *p_clnt_filter;
+  struct s_clntbuf      *p_clntbuf;
+  struct s_opc1         *p_opc1;
+  s_evcli               *ps_evcli;
 
-  v_mem_clnup[0] = 0;
+  /* +++ allocate connection state +++ */
+  ps_evcli = (s_evcli *) malloc(sizeof(s_evcli));
+  if (ps_evcli == NULL)
+  {
+     printf("E-%s: malloc(s_evcli) failed!\n", c_modnam);
+     return(-1);
+  }
+  memset(ps_evcli, 0, sizeof(s_evcli));
+  ps_chan->p_evcli = ps_evcli;
 
   /* +++ allocate filter structure +++ */
   p_clnt_filter = (struct s_clnt_filter *) malloc( sizeof(struct s_clnt_filter) );
@@ -211,12 +228,12 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
   {
      printf("E-%s: calloc(,...s_clnt_filter) failed!\n", c_modnam);
      printf("F-%s: aborting program execution!\n",c_modnam);
-     f_clnup(v_mem_clnup, NULL);
+     f_evcli_free(ps_chan);
      return(-1);
   }
   ps_chan->pc_evt_buf=(char *) p_clnt_filter;
   /* save value for clnup */
-  f_clnup_save(v_mem_clnup, (int *) p_clnt_filter);
+  f_clnup_save(ps_evcli->v_mem_clnup, (int *) p_clnt_filter);
   memset( (void *) p_clnt_filter, 0, sizeof(struct s_clnt_filter) );
 
   p_clnt_filter->l_testbit = GPS__ENV_TESTBIT;   /* set testbit              */
@@ -251,20 +268,20 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
      printf("E-%s: Severe Error in f_fltdscr! Status:%d\n",
             c_modnam,
             l_status);
-     f_clnup(v_mem_clnup, NULL);
+     f_evcli_free(ps_chan);
      return(-1);
   }
   p_clnt_filter->l_sample_rate = l_asample;
   p_clnt_filter->l_flush_rate = FLUSH__TIME;
 
-  l_timeout = TCP__TIMEOUT ;
   strcpy(c_node,pc_node);
   l_port = l_aport;
 
-  l_status = (int) f_stc_connectserver(c_node,
-                                        l_port,
-                                        &i_channel,
-                                        &s_tcpcomm_ec);
+  l_status = (int) f_stc_connectopt(c_node,
+                                     l_port,
+                                     &i_channel,
+                                     &ps_evcli->s_tcpcomm_ec,
+                                     &ps_chan->s_stcopt);
   if ((l_status & 1) != STC__SUCCESS)
   {
      printf("E-%s: Error connecting node:%s, port:%d. Msg:\n",
@@ -272,10 +289,12 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
             c_node,
             l_port);
      f_stc_disperror((int) l_status,c_retmsg, 0);
-     f_stc_close(&s_tcpcomm_ec);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+     f_evcli_free(ps_chan);
      return(l_status);
   }
   ps_chan->l_channel_no=i_channel;
+  f_stc_epoll(&ps_evcli->s_tcpcomm_ec); /* else read with select */
      /* + buffer flushing time + */
      i_h = p_clnt_filter->l_flush_rate / 3600;      /* hours                 */
      i_s = p_clnt_filter->l_flush_rate - i_h * 3600;
@@ -295,7 +314,8 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
             c_modnam,
             l_status);
      f_stc_disperror((int) l_status,c_retmsg, 0);
-     f_stc_close(&s_tcpcomm_ec);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+     f_evcli_free(ps_chan);
      return(l_status);
   }
   /* + + + + + + + + + + + + + + */
@@ -306,11 +326,12 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
   {
      printf("E-%s: malloc(p_clntbuf) failed!\n", c_modnam);
      printf("F-%s: aborting program execution!\n",c_modnam);
-     f_stc_close(&s_tcpcomm_ec);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+     f_evcli_free(ps_chan);
      return(-1);
   }
   /* save value for clnup */
-  f_clnup_save(v_mem_clnup, (int *) p_clntbuf);
+  f_clnup_save(ps_evcli->v_mem_clnup, (int *) p_clntbuf);
 
   ps_chan->pc_io_buf = (char *) p_clntbuf;
   ps_chan->l_io_buf_size = GPS__OUTBUFSIZ + CLNT__OUTBUFHEAD;
@@ -320,36 +341,37 @@ int f_evcli_con(s_evt_channel *ps_chan, const char *pc_node, int l_aport, int l_
   memset(p_clntbuf,0, sizeof(struct s_clntbuf));      /* clear memory  */
   l_status = f_read_server(ps_chan,
                            &l_retval,
-                           l_timeout,
-                           i_channel);
+                           TCP__TIMEOUT);
   if (l_status != TRUE)
   {
      printf("E-%s: Error reading 1st buffer: f_read_server()!\n", c_modnam);
-     f_stc_close(&s_tcpcomm_ec);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+     f_evcli_free(ps_chan);
      return(l_status);
   }
 
   /* ++++++++++++++++++++++++++++++++++++ */
   /* +++ check if a LW swap is needed +++ */
   /* ++++++++++++++++++++++++++++++++++++ */
-  lf_swap       = (p_clntbuf->l_testbit == GPS__ENV_TESTBIT) ? 0 : 1;
-  l_endian_serv = p_clntbuf->l_endian;
+  ps_evcli->lf_swap       = (p_clntbuf->l_testbit == GPS__ENV_TESTBIT) ? 0 : 1;
+  ps_evcli->l_endian_serv = p_clntbuf->l_endian;
 
-  if (lf_swap)
+  if (ps_evcli->lf_swap)
   /* + + + + + + + + + + + + + + + + + */
   /* +++ swap after every receive  +++ */
   /* + + + + + + + + + + + + + + + + + */
   {
-     l_sts     = F__SWAP(&p_clntbuf->l_testbit,CLNT__BUFH_LW,0);
+     F__SWAP(&p_clntbuf->l_testbit,CLNT__BUFH_LW,0);
 
      l_len_lw2 = CLNT__REST_LW + p_clntbuf->l_dlen/4; /* <N> !!! */
-     l_sts     = F__SWAP(&p_clntbuf->l_inbuf_read_cnt, l_len_lw2, 0);
+     F__SWAP(&p_clntbuf->l_inbuf_read_cnt, l_len_lw2, 0);
 
      if (p_clntbuf->l_testbit != GPS__ENV_TESTBIT)  /* <T> */
      {
         printf("F-%s: Error swapping first buffer from client\n",
                 c_modnam);
-     f_stc_close(&s_tcpcomm_ec);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+     f_evcli_free(ps_chan);
         return(-1);
      }
   }
@@ -382,14 +404,19 @@ int f_evcli_buf(s_evt_channel *ps_chan)
 {
   s_ve10_1 *ps_ve10_1;
   char *ps_buf;
+  int l_status, l_sts, l_retval, l_len_lw2;
+  unsigned int *pl_inbuf;
+  struct s_clntbuf *p_clntbuf;
+  s_evcli *ps_evcli = (s_evcli *) ps_chan->p_evcli;
   /* ++++++++++++++++++++++++++++++ */
   /* +++ send acknowledge buffer +++ */
   /* ++++++++++++++++++++++++++++++ */
-  l_status = f_send_ackn(1, ps_chan->l_channel_no);
+  l_status = f_send_ackn(ps_chan, 1);
   if (l_status != TRUE)
   {
      printf("E-%s: Error sending acknowledge: f_send_ackn()!\n", c_modnam);
-     f_stc_close(&s_tcpcomm_ec);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+     ps_evcli->l_closed = 1;
      return(l_status);
   }
     /* +++++++++++++++++++++++++ */
@@ -400,27 +427,25 @@ int f_evcli_buf(s_evt_channel *ps_chan)
     memset(p_clntbuf,0, ps_chan->l_io_buf_size);
     l_status = f_read_server(ps_chan,
                              &l_retval,
-                             l_timeout,
-                             ps_chan->l_channel_no);
+                             TCP__TIMEOUT);
     /* in case pc_io_buf has been reallocated */
     if(ps_buf != ps_chan->pc_io_buf)
     {
-      f_clnup(v_mem_clnup, NULL); /* free all old buffers */
+      f_clnup(ps_evcli->v_mem_clnup, NULL); /* free all old buffers */
       p_clntbuf =  (struct s_clntbuf *) ps_chan->pc_io_buf;
-      f_clnup_save(v_mem_clnup, (int *) p_clntbuf);
+      f_clnup_save(ps_evcli->v_mem_clnup, (int *) p_clntbuf);
     }
     if (l_status != TRUE)
     {
        printf("E-%s: Error reading buffer: f_read_server()!\n", c_modnam);
-       f_stc_close(&s_tcpcomm_ec);
+       f_stc_close(&ps_evcli->s_tcpcomm_ec);
+       ps_evcli->l_closed = 1;
        return(l_status);
     }
-    l_clnt_sts = 0;                                                /* reset */
-
     /* +++++++++++++++++++++++++++++++++ */
     /* +++ swap every buffer in loop +++ */
     /* +++++++++++++++++++++++++++++++++ */
-    if (lf_swap)
+    if (ps_evcli->lf_swap)
     {
        l_sts     = F__SWAP(&p_clntbuf->l_testbit,CLNT__BUFH_LW, 0);
        l_len_lw2 = CLNT__REST_LW + p_clntbuf->l_dlen/4; /* <N> !!! */
@@ -471,6 +496,7 @@ int f_evcli_evt(s_evt_channel *ps_chan)
 {
   int *ps_int;
   s_ve10_1 *ps_ve10_1;
+  struct s_clntbuf *p_clntbuf;
 
   p_clntbuf =  (struct s_clntbuf *) ps_chan->pc_io_buf;
   if(ps_chan->l_evt_buf_posi < p_clntbuf->l_events)
@@ -488,19 +514,27 @@ int f_evcli_evt(s_evt_channel *ps_chan)
 /***************************************************************************/
 int f_evcli_close(s_evt_channel *ps_chan)
 {
-  /* ++++++++++++++++++++++++++++++ */
-  /* +++ send acknowledge buffer +++ */
-  /* ++++++++++++++++++++++++++++++ */
-  l_status = f_send_ackn(8, ps_chan->l_channel_no);
-  if (l_status != TRUE)
+  int l_status;
+  s_evcli *ps_evcli = (s_evcli *) ps_chan->p_evcli;
+
+  if (ps_evcli == NULL) return(STC__SUCCESS);
+  l_status = STC__SUCCESS;
+  /* f_evcli_buf has closed the socket after an error */
+  if (ps_evcli->l_closed == 0)
   {
-     printf("E-%s: Error sending acknowledge: f_send_ackn()!\n", c_modnam);
-     return(l_status);
-  }
-     f_clnup(v_mem_clnup, NULL);
+     /* ++++++++++++++++++++++++++++++ */
+     /* +++ send acknowledge buffer +++ */
+     /* ++++++++++++++++++++++++++++++ */
+     l_status = f_send_ackn(ps_chan, 8);
+     if (l_status != TRUE)
+        printf("E-%s: Error sending acknowledge: f_send_ackn()!\n", c_modnam);
      f_stc_discclient(ps_chan->l_channel_no);
-     f_stc_close(&s_tcpcomm_ec);
-return(STC__SUCCESS);
+     f_stc_close(&ps_evcli->s_tcpcomm_ec);
+  }
+     f_clnup(ps_evcli->v_mem_clnup, NULL);
+     free(ps_evcli);
+     ps_chan->p_evcli = NULL;
+return(l_status);
 }
 
 
@@ -1404,10 +1438,9 @@ int f_typflt(struct s_clnt_filter* p_clnt_filter)
 /*                                                                    */
 /*                                                                    */
 /*--------------------------------------------------------------------*/
-/*+ CALLING     : sts = f_read_server(p_clntbuf,                      */
+/*+ CALLING     : sts = f_read_server(ps_chan,                        */
 /*                                       p_bytrd,                     */
-/*                                       l_timeout,                   */
-/*                                       i_chan)                      */
+/*                                       l_timeout)                   */
 /*                                                                    */
 /*                                                                    */
 /*--------------------------------------------------------------------*/
@@ -1415,10 +1448,9 @@ int f_typflt(struct s_clnt_filter* p_clnt_filter)
 /*+ PURPOSE     : Read a buffer from the server                       */
 /*                                                                    */
 /*+ ARGUMENTS   :                                                     */
-/*+    p_clntbuf: Pointer to structure s_clntbuf                      */
+/*+    ps_chan  : Channel, reads into its buffer s_clntbuf            */
 /*+    p_bytrd  : Pointer to (int) Number of read bytes              */
 /*+    l_timeout: (int) Timeout in seconds                           */
-/*+    i_chan   : (int) channel number                                */
 /*                                                                    */
 /*+ FUNCTION    : Read a buffer of the type s_clntbuf from the        */
 /*                server.                                             */
@@ -1444,11 +1476,11 @@ int f_typflt(struct s_clnt_filter* p_clnt_filter)
 /*                                                                    */
 /*3+Description***+***********+****************************************/
 /*1- C Procedure ***********+******************************************/
-int f_read_server(s_evt_channel* ps_chan, int* p_bytrd, int l_timeout, int i_chan)
+int f_read_server(s_evt_channel* ps_chan, int* p_bytrd, int l_timeout)
 {
   /* ++++ declarations ++++ */
 int             l_maxbytes;
-  int            l_status,ii,im,*pl;                              /* !!! */
+  int            l_status,ii,*pl;                                 /* !!! */
   int           l_bytrec, l_2ndbuf_byt;
   int           l_buftord, l_buffertype;
   static char    c_modnam[] = "f_read_server";
@@ -1456,6 +1488,8 @@ int             l_maxbytes;
   char *pc;
   int *pl_d,*pl_s;
   s_ve10_1 *ps_ve10_1;
+  struct s_clntbuf *p_clntbuf;
+  s_evcli *ps_evcli = (s_evcli *) ps_chan->p_evcli;
 
   /* ++++ action       ++++ */
 
@@ -1474,10 +1508,10 @@ int             l_maxbytes;
 
 
   *p_bytrd = CLNT__SMALLBUF;
-  l_status = f_stc_read( (char *) p_clntbuf,
-                         (int) CLNT__SMALLBUF,
-                         i_chan,
-                         l_timeout);
+  l_status = f_stc_recv(&ps_evcli->s_tcpcomm_ec,
+                        (char *) p_clntbuf,
+                        (int) CLNT__SMALLBUF,
+                        l_timeout);
 
   if (l_status != STC__SUCCESS)
   {
@@ -1563,11 +1597,9 @@ int             l_maxbytes;
   /* old buffer is freed by caller */
   if(l_bytrec > l_maxbytes)
   {
-      im=l_bytrec;
       l_bytrec=(int)(1.2*(float)l_bytrec);
       l_bytrec=((l_bytrec>>12)+1);
       l_bytrec=(l_bytrec<<12);
-      /*      printf("reallocate for %d (%d) bytes\n",im,l_bytrec);fflush(stdout);*/
       pc =  (char*) malloc(l_bytrec);
       pl_d=(int *)pc;
       for(ii=0;ii<l_bytrec/4;ii++) *pl_d++ = 0;
@@ -1578,18 +1610,11 @@ int             l_maxbytes;
       ps_chan->l_io_buf_size = l_bytrec;
       p_clntbuf = (struct s_clntbuf *) pc;
   }
+  /* the rest of the client buffer at once, the server waits for the ackn */
   pl = (int *) &p_clntbuf->c_buffer[CLNT__RESTBUF];
-  im=l_2ndbuf_byt/16384;
-  l_2ndbuf_byt=l_2ndbuf_byt%16384;
-  for(ii=0;ii<im;ii++)
-  {
-    l_status = f_stc_read( pl,16384,i_chan,l_timeout);
-    pl+=4096;
-    if(l_status != STC__SUCCESS)break;
-  }
   if(l_2ndbuf_byt > 0)
   {
-    l_status = f_stc_read( pl,l_2ndbuf_byt,i_chan,l_timeout);
+    l_status = f_stc_recv(&ps_evcli->s_tcpcomm_ec,pl,l_2ndbuf_byt,l_timeout);
   }
   if (l_status != STC__SUCCESS)
   {
@@ -1621,12 +1646,12 @@ int             l_maxbytes;
   /* ++++++++++++++++++++++++++++++++++ */
   /* + + + send acknowledge buffer + + + */
   /* ++++++++++++++++++++++++++++++++++ */
-  s_ackn.l_ack_buf   = l_buftord;
-  s_ackn.l_ack_bytes = *p_bytrd;
-  s_ackn.l_clnt_sts  = 1;                    /* success                      */
+  ps_evcli->s_ackn.l_ack_buf   = l_buftord;
+  ps_evcli->s_ackn.l_ack_bytes = *p_bytrd;
+  ps_evcli->s_ackn.l_clnt_sts  = 1;                    /* success                      */
 
   if ((l_buffertype & 8) != 0)
-     s_ackn.l_clnt_sts = s_ackn.l_clnt_sts | 8;  /* set bit for last buffer  */
+     ps_evcli->s_ackn.l_clnt_sts = ps_evcli->s_ackn.l_clnt_sts | 8;  /* set bit for last buffer  */
 
   return(TRUE);
 }
@@ -1638,15 +1663,15 @@ int             l_maxbytes;
 /*                                                                    */
 /*                                                                    */
 /*--------------------------------------------------------------------*/
-/*+ CALLING     : sts = f_send_ackn(l_clnt_sts, i_chan)               */
+/*+ CALLING     : sts = f_send_ackn(ps_chan, l_clnt_sts)              */
 /*--------------------------------------------------------------------*/
 /*                                                                    */
 /*+ PURPOSE     : Send acknowledge buffer to the server                */
 /*                                                                    */
 /*+ ARGUMENTS   :                                                     */
+/*+   ps_chan  : Channel connected by f_evcli_con.                    */
 /*+   l_clnt_sts: Status. Status bits will be set in addition to the  */
 /*                status  bits set by f_read_server in s_ackn struct. */
-/*+    i_chan   : (int) channel number                                */
 /*                                                                    */
 /*+ FUNCTION    : Send the acknowledge buffer. Set additional bits in  */
 /*                the status word, i.e. "last buffer" etc.            */
@@ -1670,30 +1695,31 @@ int             l_maxbytes;
 /*                                                                    */
 /*3+Description***+***********+****************************************/
 /*1- C Procedure ***********+******************************************/
-int f_send_ackn(int l_clnt_sts, int i_chan)
+int f_send_ackn(s_evt_channel *ps_chan, int l_clnt_sts)
 {
   /* ++++ declarations ++++ */
   int            l_status;                              /* !!! */
   static char    c_modnam[] = "f_send_ackn";
   char           c_retmsg[256];
+  s_evcli        *ps_evcli = (s_evcli *) ps_chan->p_evcli;
 
   if (i_debug == 2)
      printf("I-%s s_ackn.l_clnt_sts:%d l_clnt_sts:%d\n",
              c_modnam,
-             s_ackn.l_clnt_sts,
+             ps_evcli->s_ackn.l_clnt_sts,
              l_clnt_sts);
 
   /* +++++++++++++++++++++++++++++++ */
   /* +++ set status of ackn buf  +++ */
   /* +++++++++++++++++++++++++++++++ */
-  s_ackn.l_clnt_sts  = s_ackn.l_clnt_sts | l_clnt_sts; /* success            */
+  ps_evcli->s_ackn.l_clnt_sts  = ps_evcli->s_ackn.l_clnt_sts | l_clnt_sts; /* success            */
 
   /* ++++++++++++++++++++++++++++++ */
   /* +++ send acknowledge buffer +++ */
   /* ++++++++++++++++++++++++++++++ */
-  l_status = f_stc_write( (char *) &s_ackn,
+  l_status = f_stc_write( (char *) &ps_evcli->s_ackn,
                           12,
-                          i_chan);
+                          ps_chan->l_channel_no);
 
   if (l_status != STC__SUCCESS)
   {
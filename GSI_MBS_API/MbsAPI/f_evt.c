@@ -76,6 +76,8 @@
 #include <sys/timeb.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <netinet/tcp.h>
 #define DEF_FILE_ACCE S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH  /* rw-r--r-- */
 #define GET__OPEN_FLAG O_RDONLY
 #define PUT__OPEN_APD_FLAG O_RDWR|O_APPEND
@@ -171,18 +173,27 @@
 #include "gps_sc_def.h"
 #include "f_evt.h"
 #include "f_evcli.h"
+#include "f_ut_blkrd.h"
+#include "f_ut_swap4.h"
 #include "portnum_def.h"
 
 INTS4 f_evt_get_newbuf(s_evt_channel *);
+INTS4 f_evt_map_file(s_evt_channel *);
+void  f_evt_map_advise(s_evt_channel *, lmdoff_t);
+void  f_evt_unmap_file(s_evt_channel *);
+INTS4 f_evt_read_block(s_evt_channel *);
+INTS4 f_evt_ahead_start(s_evt_channel *);
+void  f_evt_stream_request(s_evt_channel *);
+void  f_evt_ahead_stop(s_evt_channel *);
 INTS4 f_evt_check_buf(CHARS *,INTS4 *, INTS4 *, INTS4 *, INTS4 *);
 INTS4 f_evt_ini_bufhe(s_evt_channel *ps_chan);
 INTS4 f_evt_swap_filhe(s_bufhe *);
+void  f_evt_swap_lazy(s_evt_channel *, INTS4);
 INTS4 f_ut_utime(INTS4, INTS4, CHARS *);
 
-static struct s_tcpcomm s_tcpcomm_st_evt;
-static CHARS c_temp[MAX_BUF_LGTH];
-static int l_gl_source_port = 0;
-static int l_gl_evt_check = 0;
+
+#define MAP__AHEAD 0x800000 /* bytes announced with MADV_WILLNEED at once */
+static int l_gl_source_port = 0; /* default of channels without f_evt_server_port */
 
 /*1+ C Procedure *************+****************************************/
 /*                                                                    */
@@ -521,6 +532,32 @@ INTS4 f_evt_rev_port(INTS4 l_port)
   return 0;
 }
 
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_server_port                                   */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_server_port(s_evt_channel *ps_chan, long l_port) */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : f_evt_server_port sets the port number of the server */
+/*                for one channel, before f_evt_get_open.             */
+/*+ ARGUMENTS   :                                                     */
+/*+   ps_chan   : Input channel.                                      */
+/*+   l_port    : Port number, 0: port of f_evt_source_port or the    */
+/*                default port of the server type.                    */
+/*+ Return type : int.                                                */
+/*+ Status codes:                                                     */
+/*-               GETEVT__SUCCESS   : success.                        */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_server_port(s_evt_channel *, INTS4); */
+/*+ FUNCTION    : Unlike f_evt_source_port, it does not change the    */
+/*                port of other channels.                             */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_server_port(s_evt_channel *ps_chan, INTS4 l_port)
+{
+  ps_chan->l_port=l_port;
+  return(GETEVT__SUCCESS);
+}
+
 /*1+ C Main ****************+******************************************/
 /*+ Module      : f_evt_get_open                                      */
 /*--------------------------------------------------------------------*/
@@ -572,7 +609,8 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
    */
    INTS4 l_status;
 
-   l_port = l_gl_source_port;
+   l_port = ps_chan->l_port;
+   if(l_port <= 0) l_port = l_gl_source_port;
 
 
 #ifndef GSI__WINNT
@@ -610,7 +648,7 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
           return(GETEVT__NOFILE);
        }
        /* read first 512 bytes */
-       if(read(ps_chan->l_channel_no,c_temp,MIN_BUF_LGTH)!=MIN_BUF_LGTH) {
+       if(read(ps_chan->l_channel_no,ps_chan->c_head,MIN_BUF_LGTH)!=MIN_BUF_LGTH) {
          printf("LMD format error: no LMD file: %s\n",c_file);
          close(ps_chan->l_channel_no);
          ps_chan->l_channel_no=-1;
@@ -618,17 +656,22 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
        }
 // DABC
    ps_chan->pLmd=NULL;
-      if((*((INTS4 *)(c_temp+4)) == LMD__TYPE_FILE_HEADER_101_1)||
-         (*((INTS4 *)(c_temp+4)) == 0x65000100)){
+      if((*((INTS4 *)(ps_chan->c_head+4)) == LMD__TYPE_FILE_HEADER_101_1)||
+         (*((INTS4 *)(ps_chan->c_head+4)) == 0x65000100)){
        close(ps_chan->l_channel_no);
        ps_chan->pLmd=fLmdAllocateControl();
        fLmdGetOpen(ps_chan->pLmd,c_file,NULL,LMD__BUFFER,LMD__NO_INDEX);
+       if(ps_chan->l_mmap==1) fLmdGetMap(ps_chan->pLmd);
+       if((ps_chan->l_read_ahead>0)&&(ps_chan->pLmd->pMap==NULL)&&(ps_chan->l_follow==0))
+         fLmdSetReadAhead(ps_chan->pLmd,ps_chan->l_file_block,ps_chan->l_read_ahead,ps_chan->l_uring);
+       fLmdSetLazySwap(ps_chan->pLmd,ps_chan->l_lazy_swap);
+       fLmdSetFollow(ps_chan->pLmd,ps_chan->l_follow);
         ps_chan->l_server_type=l_mode;
         return GETEVT__SUCCESS;
       }
 // -- DABC
        /* check for file header, return size and swap */
-       f_evt_check_buf(c_temp, &l_size_head, &l_is_goosybuf, &l_swap_head, &l_filehead);
+       f_evt_check_buf(ps_chan->c_head, &l_size_head, &l_is_goosybuf, &l_swap_head, &l_filehead);
        if(((l_is_goosybuf==0)&(l_filehead==0))|(l_size_head==0)) {
          printf("LMD format error: swap=%d, header=%d, isLMD=%d, size=%d\n",l_swap_head,l_filehead,l_is_goosybuf,l_size_head);
          close(ps_chan->l_channel_no);
@@ -640,22 +683,22 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
        if(l_filehead == 1) {
          lseek(ps_chan->l_channel_no, 0, SEEK_SET);  /* rewind file */
          l_header_size=l_size_head;
-         if(((s_filhe *)c_temp)->filhe_dlen > MAX__DLEN){
-           l_header_size=((s_filhe *)c_temp)->filhe_used*2+48;
+         if(((s_filhe *)ps_chan->c_head)->filhe_dlen > MAX__DLEN){
+           l_header_size=((s_filhe *)ps_chan->c_head)->filhe_used*2+48;
          //  printf("Large buffer, read short header %d bytes\n",l_header_size);
        }
-         if(read(ps_chan->l_channel_no,c_temp,l_header_size)!=l_header_size){
+         if(read(ps_chan->l_channel_no,ps_chan->c_head,l_header_size)!=l_header_size){
            printf("LMD format error: no LMD file: %s\n",c_file);
            close(ps_chan->l_channel_no);
            ps_chan->l_channel_no=-1;
            return(GETEVT__NOLMDFILE);
          }
-         if(read(ps_chan->l_channel_no,c_temp,MIN_BUF_LGTH)!=MIN_BUF_LGTH) {
+         if(read(ps_chan->l_channel_no,ps_chan->c_head,MIN_BUF_LGTH)!=MIN_BUF_LGTH) {
            close(ps_chan->l_channel_no);
            ps_chan->l_channel_no=-1;
            return(GETEVT__RDERR);
          }
-         f_evt_check_buf(c_temp, &l_size, &l_is_goosybuf, &l_swap, &l_dummy);
+         f_evt_check_buf(ps_chan->c_head, &l_size, &l_is_goosybuf, &l_swap, &l_dummy);
          if((l_is_goosybuf==0)|(l_size!=l_size_head)|(l_swap!=l_swap_head)) {
            printf("LMD format error: swap=%d, isLMD=%d, size=%d\n",l_swap,l_is_goosybuf,l_size);
            close(ps_chan->l_channel_no);
@@ -668,16 +711,16 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
        if(ps_info != NULL) *ps_info=NULL;
        /* found file header */
        if(l_filehead == 1) {
-         if(read(ps_chan->l_channel_no,c_temp,l_header_size)!=l_header_size) {
+         if(read(ps_chan->l_channel_no,ps_chan->c_head,l_header_size)!=l_header_size) {
            printf("LMD format error: no LMD file: %s\n",c_file);
            close(ps_chan->l_channel_no);
            ps_chan->l_channel_no=-1;
            return(GETEVT__NOLMDFILE);
          }
-         ps_filhe = (s_filhe *) c_temp;
+         ps_filhe = (s_filhe *) ps_chan->c_head;
          if(ps_info != NULL) {/* if user want file header be returned */
             if( l_swap_head ==1) f_evt_swap_filhe((s_bufhe *)ps_filhe);
-            *ps_info=c_temp; /* now , get file header and return */
+            *ps_info=ps_chan->c_head; /* now , get file header and return */
          }
          /*
          printf("type %d, subtype %d\n",ps_filhe->filhe_type,ps_filhe->filhe_subtype);
@@ -691,7 +734,7 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
          pi=(INTS2 *)&ps_filhe->s_strings;
          for(l_dummy=0;l_dummy<ps_filhe->filhe_lines;l_dummy++)
          {
-           printf("comment %d, %s\n",*pi,(c_temp+366+l_dummy*80));
+           printf("comment %d, %s\n",*pi,(ps_chan->c_head+366+l_dummy*80));
            pi += 40;
          }
          */
@@ -701,36 +744,56 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
       /* and read header buffer, if there */
        ps_chan->l_io_buf_size=ps_chan->l_buf_size;
        /* may larger, but must multiplexed */
+       if(ps_chan->l_file_block > ps_chan->l_buf_size)
+          ps_chan->l_io_buf_size=(ps_chan->l_file_block/ps_chan->l_buf_size)*ps_chan->l_buf_size;
        break;
     case GETEVT__STREAM :
 
        if (l_port<=0) l_port = PORT__STREAM_SERV;
 
       /* initialize connection with stream server                  */
-      if(f_stc_connectserver(pc_server,l_port,&ps_chan->l_channel_no,
-         &s_tcpcomm_st_evt)!=STC__SUCCESS)
+      if(f_stc_connectopt(pc_server,l_port,&ps_chan->l_channel_no,
+         &ps_chan->s_tcpcomm,&ps_chan->s_stcopt)!=STC__SUCCESS)
       {
+         ps_chan->l_channel_no=-1; /* closed already */
          return(GETEVT__NOSERVER);
       }
+      f_stc_epoll(&ps_chan->s_tcpcomm); /* else read with select */
 
-      l_status=f_stc_read(c_temp,16,ps_chan->l_channel_no,ps_chan->l_timeout);
-      if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
-      if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
+      l_status=f_stc_recv(&ps_chan->s_tcpcomm,ps_chan->c_head,16,ps_chan->l_timeout);
+      if(l_status != STC__SUCCESS)
+      {
+         /* no connection is left behind, the open may be tried again */
+         f_stc_close(&ps_chan->s_tcpcomm);
+         ps_chan->l_channel_no=-1;
+         return((l_status == STC__TIMEOUT) ? GETEVT__TIMEOUT : GETEVT__RDERR);
+      }
 
-      if( *((INTS4 *)(c_temp))!=1)f_evt_swap(c_temp, 16);
-      ps_chan->l_buf_size=*((INTS4 *)(c_temp+4)); /* buffer size */
-      ps_chan->l_bufs_in_stream=*((INTS4 *)(c_temp+8));
+      if( *((INTS4 *)(ps_chan->c_head))!=1)f_evt_swap(ps_chan->c_head, 16);
+      ps_chan->l_buf_size=*((INTS4 *)(ps_chan->c_head+4)); /* buffer size */
+      ps_chan->l_bufs_in_stream=*((INTS4 *)(ps_chan->c_head+8));
       /* # buffers per stream */
       ps_chan->l_stream_bufs = 0; /* counter */
+      ps_chan->l_stream_pending = 0;
+#ifdef TCP_NODELAY
+      /* requests sent ahead must not wait for the acknowledge of the previous one,
+         unless TCP_NODELAY is switched off with f_evt_socket_options */
+      if((ps_chan->l_stream_depth > 0)&&(ps_chan->s_stcopt.l_nodelay == 0))
+      {
+         l_status=1;
+         setsockopt(ps_chan->l_channel_no,IPPROTO_TCP,TCP_NODELAY,(char *)&l_status,sizeof(l_status));
+      }
+#endif
 
       ps_chan->l_io_buf_size=(ps_chan->l_buf_size)*(ps_chan->l_bufs_in_stream);
 // DABC
    ps_chan->pLmd=NULL;
-      if(*((INTS4 *)(c_temp+12)) == 0) {
+      if(*((INTS4 *)(ps_chan->c_head+12)) == 0) {
         ps_chan->pLmd=fLmdAllocateControl();
-        ps_chan->pLmd->pTCP=&s_tcpcomm_st_evt;
+        ps_chan->pLmd->pTCP=&ps_chan->s_tcpcomm;
         // SL: we should deliver default portnumber while it is used only to identify transport
         fLmdInitMbs(ps_chan->pLmd,pc_server,ps_chan->l_buf_size,ps_chan->l_bufs_in_stream,0,PORT__STREAM_SERV,ps_chan->l_timeout);
+        fLmdSetRequestDepth(ps_chan->pLmd,ps_chan->l_stream_depth);
         printf("f_evt_get_open for STREAM: port=%d timeout=%d  \n",l_port, ps_chan->l_timeout);
 
         ps_chan->l_server_type=l_mode;
@@ -743,26 +806,33 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
       if (l_port<=0) l_port = PORT__TRANSPORT;
 
       /* initialize connection with stream server                  */
-      if(f_stc_connectserver(pc_server,l_port,&ps_chan->l_channel_no,
-         &s_tcpcomm_st_evt)!=STC__SUCCESS)
+      if(f_stc_connectopt(pc_server,l_port,&ps_chan->l_channel_no,
+         &ps_chan->s_tcpcomm,&ps_chan->s_stcopt)!=STC__SUCCESS)
       {
+         ps_chan->l_channel_no=-1; /* closed already */
          return(GETEVT__NOSERVER);
       }
+      f_stc_epoll(&ps_chan->s_tcpcomm); /* else read with select */
 
-      l_status=f_stc_read(c_temp,16,ps_chan->l_channel_no,ps_chan->l_timeout);
-      if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
-      if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
+      l_status=f_stc_recv(&ps_chan->s_tcpcomm,ps_chan->c_head,16,ps_chan->l_timeout);
+      if(l_status != STC__SUCCESS)
+      {
+         /* no connection is left behind, the open may be tried again */
+         f_stc_close(&ps_chan->s_tcpcomm);
+         ps_chan->l_channel_no=-1;
+         return((l_status == STC__TIMEOUT) ? GETEVT__TIMEOUT : GETEVT__RDERR);
+      }
 
-      if( *((INTS4 *)(c_temp))!=1)f_evt_swap(c_temp, 16);
-      ps_chan->l_buf_size=*((INTS4 *)(c_temp+4)); /* buffer size */
-      ps_chan->l_bufs_in_stream=*((INTS4 *)(c_temp+8));
+      if( *((INTS4 *)(ps_chan->c_head))!=1)f_evt_swap(ps_chan->c_head, 16);
+      ps_chan->l_buf_size=*((INTS4 *)(ps_chan->c_head+4)); /* buffer size */
+      ps_chan->l_bufs_in_stream=*((INTS4 *)(ps_chan->c_head+8));
       /* # buffers per stream */
       ps_chan->l_io_buf_size=ps_chan->l_buf_size;
 // DABC
    ps_chan->pLmd=NULL;
-      if(*((INTS4 *)(c_temp+12)) == 0) {
+      if(*((INTS4 *)(ps_chan->c_head+12)) == 0) {
         ps_chan->pLmd=fLmdAllocateControl();
-        ps_chan->pLmd->pTCP=&s_tcpcomm_st_evt;
+        ps_chan->pLmd->pTCP=&ps_chan->s_tcpcomm;
         fLmdInitMbs(ps_chan->pLmd,pc_server,ps_chan->l_buf_size,ps_chan->l_bufs_in_stream,0,PORT__TRANSPORT,ps_chan->l_timeout);
         printf("f_evt_get_open for TRANSPORT: port=%d timeout=%d  \n",l_port, ps_chan->l_timeout);
         ps_chan->l_server_type=l_mode;
@@ -789,7 +859,7 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
      ps_chan->l_channel_no=RFIO_open(pc_server,GET__OPEN_FLAG,0);
      if(ps_chan->l_channel_no < 0) return(GETEVT__NOSERVER);
       /* read first 512 bytes */
-      if(RFIO_read(ps_chan->l_channel_no,c_temp,MIN_BUF_LGTH)!=MIN_BUF_LGTH)
+      if(RFIO_read(ps_chan->l_channel_no,ps_chan->c_head,MIN_BUF_LGTH)!=MIN_BUF_LGTH)
    {
      printf("LMD format error: no LMD file: %s\n",pc_server);
      RFIO_close(ps_chan->l_channel_no);
@@ -797,7 +867,7 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
           return(GETEVT__NOLMDFILE);
    }
       /* check for file header, return size and swap */
-      f_evt_check_buf(c_temp, &l_size_head, &l_is_goosybuf, &l_swap_head, &l_filehead);
+      f_evt_check_buf(ps_chan->c_head, &l_size_head, &l_is_goosybuf, &l_swap_head, &l_filehead);
       if(((l_is_goosybuf==0)&(l_filehead==0))|(l_size_head==0))
    {
      printf("LMD format error: swap=%d, header=%d, isLMD=%d, size=%d\n",l_swap_head,l_filehead,l_is_goosybuf,l_size_head);
@@ -809,20 +879,20 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
       if(l_filehead == 1)
       {
         RFIO_lseek(ps_chan->l_channel_no, 0, SEEK_SET);  /* rewind file */
-      if(RFIO_read(ps_chan->l_channel_no,c_temp,l_size_head)!=l_size_head)
+      if(RFIO_read(ps_chan->l_channel_no,ps_chan->c_head,l_size_head)!=l_size_head)
         {
      printf("LMD format error: no LMD file: %s\n",pc_server);
      RFIO_close(ps_chan->l_channel_no);
      ps_chan->l_channel_no=-1;
           return(GETEVT__NOLMDFILE);
         }
-      if(RFIO_read(ps_chan->l_channel_no,c_temp,MIN_BUF_LGTH)!=MIN_BUF_LGTH)
+      if(RFIO_read(ps_chan->l_channel_no,ps_chan->c_head,MIN_BUF_LGTH)!=MIN_BUF_LGTH)
    {
      RFIO_close(ps_chan->l_channel_no);
      ps_chan->l_channel_no=-1;
           return(GETEVT__RDERR);
    }
-        f_evt_check_buf(c_temp, &l_size, &l_is_goosybuf, &l_swap, &l_dummy);
+        f_evt_check_buf(ps_chan->c_head, &l_size, &l_is_goosybuf, &l_swap, &l_dummy);
         if((l_is_goosybuf==0)|(l_size!=l_size_head)|(l_swap!=l_swap_head))
    {
      printf("LMD format error: swap=%d, isLMD=%d, size=%d\n",l_swap,l_is_goosybuf,l_size);
@@ -837,18 +907,18 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
       /* found file header */
       if(l_filehead == 1)
       {
-         if(RFIO_read(ps_chan->l_channel_no,c_temp,l_size_head)!=l_size_head)
+         if(RFIO_read(ps_chan->l_channel_no,ps_chan->c_head,l_size_head)!=l_size_head)
          {
      printf("LMD format error: no LMD file: %s\n",pc_server);
      RFIO_close(ps_chan->l_channel_no);
      ps_chan->l_channel_no=-1;
           return(GETEVT__NOLMDFILE);
          }
-   ps_filhe=(s_filhe *)c_temp;
+   ps_filhe=(s_filhe *)ps_chan->c_head;
         if(ps_info != NULL) /* if user want file header be returned */
         {
            if( l_swap_head ==1)f_evt_swap_filhe((s_bufhe *)ps_filhe);
-           *ps_info=c_temp; /* now , get file header and return */
+           *ps_info=ps_chan->c_head; /* now , get file header and return */
         }
    /*
    printf("type %d, subtype %d\n",ps_filhe->filhe_type,ps_filhe->filhe_subtype);
@@ -862,7 +932,7 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
    pi=(INTS2 *)&ps_filhe->s_strings;
    for(l_dummy=0;l_dummy<ps_filhe->filhe_lines;l_dummy++)
    {
-     printf("comment %d, %s\n",*pi,(c_temp+366+l_dummy*80));
+     printf("comment %d, %s\n",*pi,(ps_chan->c_head+366+l_dummy*80));
      pi += 40;
    }
    */
@@ -881,13 +951,20 @@ INTS4 f_evt_get_open(INTS4 l_mode, const CHARS *pc_server, s_evt_channel *ps_cha
         printf("Memory allocation error\n");
         exit(2);
      }
+     ps_chan->l_io_buf_max=ps_chan->l_io_buf_size;
      ps_chan->l_evt_buf_size=ps_chan->l_io_buf_size;
+     /* file blocks may be large, the event buffer grows with spanned events */
+     if(l_mode == GETEVT__FILE) ps_chan->l_evt_buf_size=ps_chan->l_buf_size;
      if( (ps_chan->pc_evt_buf=malloc(ps_chan->l_evt_buf_size))==NULL)
      {
         printf("Memory allocation error\n");
         exit(2);
      }
    } /* l_mode != GETEVT__EVENT */
+   if((l_mode == GETEVT__FILE)&&(ps_chan->l_mmap==1))
+      f_evt_map_file(ps_chan); /* on failure, the file is read as before */
+   if((l_mode == GETEVT__FILE)&&(ps_chan->l_read_ahead>0)&&(ps_chan->pc_map==NULL))
+      f_evt_ahead_start(ps_chan); /* on failure, the file is read without thread */
    ps_chan->l_server_type=l_mode;
    ps_chan->l_first_get=1;       /* so we will first call f_getvet_get */
    return GETEVT__SUCCESS;
@@ -947,6 +1024,8 @@ if(pevt==NULL){
      }
 }
 // OK
+     ps_chan->l_evt_swap = 0;
+     if(ps_chan->l_server_type == GETEVT__FILE) ps_chan->l_evt_swap = ps_chan->pLmd->iEventSwap;
      if(ppl_goobuf)*ppl_goobuf = NULL;
      *ppl_buffer = (INTS4 *)pevt;
      return(GETEVT__SUCCESS);
@@ -955,6 +1034,7 @@ if(pevt==NULL){
    if((ps_chan->l_server_type == GETEVT__EVENT)||(ps_chan->l_server_type == GETEVT__REVSERV))
    {
       *ppl_goobuf = NULL;
+      ps_chan->l_evt_swap = 0;
       if(f_evcli_evt(ps_chan) != STC__SUCCESS) /* no more event, get new buffer */
       {
 		  l_stat=f_evcli_buf(ps_chan);
@@ -981,7 +1061,10 @@ if(pevt==NULL){
     * so the second or later (open,get,close) should reset these      *
     * static value                                                    */
 
-   ps_chan->l_evt_buf_posi=0;
+   /* a spanned event interrupted by the end of a followed file is continued */
+   ps_chan->l_evt_buf_posi=ps_chan->l_follow_posi;
+   ps_chan->l_follow_posi=0;
+   ps_bufhe_cur=(s_bufhe *)&ps_chan->s_bufhe_1;
 /* above, internal event buffer position, internal buffer will be returned */
 
    while(1)
@@ -994,7 +1077,12 @@ if(pevt==NULL){
          /* end of this read_buffer which may contain several GOOSY buffers*/
          if(ps_chan->l_io_buf_posi>=ps_chan->l_io_buf_size)
          {
-            if((l_temp=f_evt_get_newbuf(ps_chan))!=GETEVT__SUCCESS) return(l_temp);
+            if((l_temp=f_evt_get_newbuf(ps_chan))!=GETEVT__SUCCESS)
+            {
+               if((l_temp == GETEVT__NOMORE)&&(ps_chan->l_follow == 1))
+                  ps_chan->l_follow_posi=ps_chan->l_evt_buf_posi;
+               return(l_temp);
+            }
             ps_chan->l_io_buf_posi=0;
          } /* end of real read server */
          ps_chan->ps_bufhe = (s_bufhe*) (ps_chan->pc_io_buf+ps_chan->l_io_buf_posi);
@@ -1002,6 +1090,8 @@ if(pevt==NULL){
          ps_chan->l_buf_no = ps_chan->ps_bufhe->l_buf;
          if(ps_chan->ps_bufhe->i_type == 2000) {   /* file header */
             printf("Unsolicited file header found!\n");
+            if(ps_chan->l_io_buf_lazy)
+               f_evt_swap((CHARS *)(ps_chan->ps_bufhe+1),ps_chan->l_buf_size-sizeof(s_bufhe));
             ps_chan->l_io_buf_posi += ps_chan->l_buf_size;
             ps_chan->l_buf_posi = ps_chan->l_io_buf_posi;
             ps_chan->l_buf_lmt  = ps_chan->l_io_buf_posi;
@@ -1010,6 +1100,7 @@ if(pevt==NULL){
             if(ps_chan->ps_bufhe->l_dlen <= MAX__DLEN)l_used=ps_chan->ps_bufhe->i_used;
             ps_chan->l_buf_posi = ps_chan->l_io_buf_posi + sizeof(s_bufhe);
             ps_chan->l_buf_lmt = ps_chan->l_buf_posi + l_used*2;
+            if(ps_chan->l_io_buf_lazy) f_evt_swap_lazy(ps_chan,l_used*2);
             ps_chan->l_io_buf_posi += ps_chan->l_buf_size;
          }
       } /* end of read file while loop */
@@ -1047,6 +1138,9 @@ if(pevt==NULL){
           ( (ps_chan->ps_bufhe->h_begin==0) || ((ps_chan->l_buf_posi+ps_chan->l_frag_len) < ps_chan->l_buf_lmt) ) )
       {
          *ppl_buffer = (INTS4 *)(ps_chan->pc_io_buf+ps_chan->l_buf_posi);
+         ps_chan->l_evt_swap = (ps_chan->l_io_buf_lazy == 1) &&
+                               (ps_chan->l_buf_posi >= ps_chan->l_lazy_begin) &&
+                               (ps_chan->l_buf_posi < ps_chan->l_lazy_end);
          ps_chan->l_buf_posi += ps_chan->l_frag_len;
          ps_chan->l_evt_buf_posi = 0;
          if(ppl_goobuf) *ppl_goobuf = (INTS4 *) (ps_chan->ps_bufhe);
@@ -1084,6 +1178,7 @@ if(pevt==NULL){
          /* change event header's l_dlen */
          ((s_ve10_1 *)(ps_chan->pc_evt_buf))->l_dlen=ps_chan->l_evt_buf_posi/2-4;
          *ppl_buffer=(INTS4 *)(ps_chan->pc_evt_buf);
+         ps_chan->l_evt_swap = 0; /* fragments are swapped completely */
          if(ppl_goobuf)*ppl_goobuf=(INTS4 *)(ps_bufhe_cur);
          return(GETEVT__SUCCESS);
       }
@@ -1128,6 +1223,8 @@ INTS4 f_evt_get_close(s_evt_channel * ps_chan)
    switch(ps_chan->l_server_type)
    {
    case GETEVT__FILE :
+      f_evt_unmap_file(ps_chan);
+      f_evt_ahead_stop(ps_chan);
       if(close(ps_chan->l_channel_no)==-1)                     l_close_failure=1;
       if(ps_chan->pc_io_buf  != NULL)free(ps_chan->pc_io_buf);
       if(ps_chan->pc_evt_buf != NULL)free(ps_chan->pc_evt_buf);
@@ -1136,14 +1233,14 @@ INTS4 f_evt_get_close(s_evt_channel * ps_chan)
       /* disconnect with stream server                              */
       f_stc_write("CLOSE", 12, ps_chan->l_channel_no);
       if(f_stc_discclient(ps_chan->l_channel_no)!=STC__SUCCESS)l_close_failure=1;
-      if(f_stc_close(&s_tcpcomm_st_evt)!=STC__SUCCESS)         l_close_failure=1;
+      if(f_stc_close(&ps_chan->s_tcpcomm)!=STC__SUCCESS)         l_close_failure=1;
       if(ps_chan->pc_io_buf  != NULL)free(ps_chan->pc_io_buf);
       if(ps_chan->pc_evt_buf != NULL)free(ps_chan->pc_evt_buf);
       break;
    case GETEVT__TRANS  :
       /* disconnect with stream server                              */
       if(f_stc_discclient(ps_chan->l_channel_no)!=STC__SUCCESS)l_close_failure=1;
-      if(f_stc_close(&s_tcpcomm_st_evt)!=STC__SUCCESS)         l_close_failure=1;
+      if(f_stc_close(&ps_chan->s_tcpcomm)!=STC__SUCCESS)         l_close_failure=1;
       if(ps_chan->pc_io_buf  != NULL)free(ps_chan->pc_io_buf);
       if(ps_chan->pc_evt_buf != NULL)free(ps_chan->pc_evt_buf);
       break;
@@ -1424,7 +1521,7 @@ INTS4 f_evt_put_event(s_evt_channel *ps_chan, INTS4 *pl_evt_buf)
       l_free = l_free + ps_chan->l_buf_size - ps_chan->l_io_buf_posi;
       if(l_free==ps_chan->l_buf_size)l_free=0;
       /* l_free is remain free space in this GOOSY buf */
-      if(l_free<sizeof(s_ve10_1))ps_chan->l_io_buf_posi += l_free;
+      if(l_free<(INTS4)sizeof(s_ve10_1))ps_chan->l_io_buf_posi += l_free;
       /* change spanned evt header l_dlen */
       if(l_evt_buf_posi!=l_write_size)
       {
@@ -1747,20 +1844,29 @@ INTS4 f_evt_get_buffer(s_evt_channel *ps_chan, INTS4 *ps_buffer)
       }
      break;
    case GETEVT__STREAM :
-      if(ps_chan->l_stream_bufs == 0)
+      if((ps_chan->l_stream_bufs == 0)&&(ps_chan->l_stream_pending == 0))
+      {
          if(f_stc_write("GETEVT", 12, ps_chan->l_channel_no)!=STC__SUCCESS)
          {
             return(GETEVT__FAILURE);
          }
+         ps_chan->l_stream_pending=1;
+      }
 
-      l_status=f_stc_read(ps_buffer, ps_chan->l_buf_size, ps_chan->l_channel_no,ps_chan->l_timeout);
+      l_status=f_stc_recv(&ps_chan->s_tcpcomm, ps_buffer, ps_chan->l_buf_size, ps_chan->l_timeout);
       if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
       if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
+      if(ps_chan->l_stream_bufs == 0)
+      {
+         /* the stream is being read, request the next ones */
+         ps_chan->l_stream_pending--;
+         f_evt_stream_request(ps_chan);
+      }
       ps_chan->l_stream_bufs++;
       if(ps_chan->l_stream_bufs == ps_chan->l_bufs_in_stream)ps_chan->l_stream_bufs = 0;
       break;
    case GETEVT__TRANS  :
-      l_status=f_stc_read(ps_buffer, ps_chan->l_buf_size, ps_chan->l_channel_no,ps_chan->l_timeout);
+      l_status=f_stc_recv(&ps_chan->s_tcpcomm, ps_buffer, ps_chan->l_buf_size, ps_chan->l_timeout);
       if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
       if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
       break;
@@ -1776,6 +1882,54 @@ INTS4 f_evt_get_buffer(s_evt_channel *ps_chan, INTS4 *ps_buffer)
 
    return(GETEVT__SUCCESS);
 } /* end of f_evt_get_buffer */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_get_block                                     */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_get_block(s_evt_channel &s_chan, CHARS **ppc_block, */
+/*                                INTS4 *pl_bytes, INTS4 *pl_swap)    */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : f_evt_get_block  returns the next block of buffers  */
+/*                of a file as read, not swapped and not decoded.     */
+/*+ ARGUMENTS   :                                                     */
+/*+   s_chan    : structure s_evt_channel.                            */
+/*+  ppc_block  : Address of pointer, set to the block.               */
+/*+  pl_bytes   : Size of the block, whole buffers of l_buf_size.     */
+/*+  pl_swap    : Set to 1, if the buffers are in other endian.       */
+/*+ Return type : int.                                                */
+/*+ Status codes:                                                     */
+/*-               GETEVT__SUCCESS   : success.                        */
+/*-               GETEVT__FAILURE   : no file in the buffer format    */
+/*-               GETEVT__RDERR     : read file error                 */
+/*-               GETEVT__NOMORE    : No more events.                 */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_get_block(s_evt_channel *, CHARS **,    */
+/*                                      INTS4 *, INTS4 *);            */
+/*+ FUNCTION    : The block has the size set by f_evt_file_block and  */
+/*                is valid until the next call. A block inside the    */
+/*                mapping of the file (f_evt_file_mmap) stays valid   */
+/*                until f_evt_get_close and may be changed in place.  */
+/*                The caller splits the buffers into events, so that  */
+/*                they can be decoded by several threads. Must not be */
+/*                mixed with f_evt_get_event on the same channel.     */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_get_block(s_evt_channel *ps_chan, CHARS **ppc_block, INTS4 *pl_bytes, INTS4 *pl_swap)
+{
+   INTS4 l_status;
+
+   if((ps_chan->l_server_type != GETEVT__FILE)||(ps_chan->pLmd != NULL)) return(GETEVT__FAILURE);
+
+   ps_chan->l_io_buf_raw=1;
+   l_status=f_evt_get_newbuf(ps_chan);
+   ps_chan->l_io_buf_raw=0;
+   if(l_status != GETEVT__SUCCESS) return(l_status);
+
+   *ppc_block=ps_chan->pc_io_buf;
+   *pl_bytes=ps_chan->l_io_buf_size;
+   *pl_swap=( ((s_bufhe *)(ps_chan->pc_io_buf))->l_free[0] != 1 ) ? 1 : 0;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_get_block */
 /*1+ C Main ****************+******************************************/
 /*+ Module      : f_evt_skip_buffer                                    */
 /*--------------------------------------------------------------------*/
@@ -1856,6 +2010,223 @@ INTS4 f_evt_timeout(s_evt_channel *ps_chan, INTS4 l_sec)
    return(GETEVT__SUCCESS);
 } /* end of f_evt_timeout */
 
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_file_mmap                                     */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_file_mmap(s_evt_channel *ps_chan, l_on)       */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Read files through a memory mapping.                */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  l_on       : 1 map files, 0 read them (default).                 */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_file_mmap(s_evt_channel *, INTS4);      */
+/*+ FUNCTION    : Must be called before f_evt_get_open.               */
+/*                f_evt_get_event returns pointers into the mapping   */
+/*                instead of copying each buffer into the I/O buffer. */
+/*                Buffers with other endian and spanned events are    */
+/*                still copied. Linux only, other systems and files   */
+/*                that can not be mapped are read.                    */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_file_mmap(s_evt_channel *ps_chan, INTS4 l_on)
+{
+   ps_chan->l_mmap = l_on;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_file_mmap */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_file_block                                    */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_file_block(s_evt_channel *ps_chan, l_bytes, l_read_ahead) */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Read files in large blocks.                         */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  l_bytes    : Bytes per read, e.g. 8 MB. Rounded down to whole    */
+/*                buffers. 0: one buffer per read (default).          */
+/*+ l_read_ahead: Blocks read ahead, 0 none.                          */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_file_block(s_evt_channel *, INTS4, INTS4); */
+/*+ FUNCTION    : Must be called before f_evt_get_open.               */
+/*                One read call fills a block of buffers, which are   */
+/*                then walked by f_evt_get_event. With l_read_ahead   */
+/*                the next blocks are read while the current one is   */
+/*                decoded, by a thread or with io_uring (Linux only). */
+/*                A mapped file, see f_evt_file_mmap, is walked in    */
+/*                blocks of the same size without read-ahead.         */
+/*                Files in the newer LMD format are read ahead in     */
+/*                blocks of this size, too. f_evt_get_buffer and      */
+/*                f_evt_skip_buffer start behind the current block.   */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_file_block(s_evt_channel *ps_chan, INTS4 l_bytes, INTS4 l_read_ahead)
+{
+   ps_chan->l_file_block = l_bytes;
+   ps_chan->l_read_ahead = l_read_ahead;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_file_block */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_file_uring                                    */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_file_uring(s_evt_channel *ps_chan, l_on)      */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Read ahead with io_uring.                           */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  l_on       : 1 io_uring, 0 a thread calling pread (default).     */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_file_uring(s_evt_channel *, INTS4);     */
+/*+ FUNCTION    : Must be called before f_evt_get_open. The reads of  */
+/*                all blocks read ahead, see f_evt_file_block, are in */
+/*                flight at the same time and are completed in order. */
+/*                Without io_uring (kernel before 5.1, not allowed by */
+/*                a seccomp filter) the thread is used.               */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_file_uring(s_evt_channel *ps_chan, INTS4 l_on)
+{
+   ps_chan->l_uring = l_on;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_file_uring */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_file_follow                                   */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_file_follow(s_evt_channel *ps_chan, l_on)     */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Read a file that is still written.                  */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  l_on       : 1 follow the file, 0 read a complete file (default).*/
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_file_follow(s_evt_channel *, INTS4);    */
+/*+ FUNCTION    : Must be called before f_evt_get_open. GETEVT__NOMORE*/
+/*                means no more data for the moment: the position in */
+/*                the file is kept, a partial buffer at the end and   */
+/*                the part of a spanned event read so far are read    */
+/*                again or continued by the next f_evt_get_event. The */
+/*                caller decides when the writer has closed the file. */
+/*                Files in the newer LMD format are not read ahead.   */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_file_follow(s_evt_channel *ps_chan, INTS4 l_on)
+{
+   ps_chan->l_follow = l_on;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_file_follow */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_stream_depth                                  */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_stream_depth(s_evt_channel *ps_chan, l_depth) */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Keep requests to a stream server outstanding.       */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  l_depth    : GETEVT requests sent ahead, 0 none (default).       */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_stream_depth(s_evt_channel *, INTS4);   */
+/*+ FUNCTION    : Must be called before f_evt_get_open. As soon as a  */
+/*                stream is read, the next l_depth streams are        */
+/*                requested. The server sends them while the caller   */
+/*                decodes the current stream, instead of waiting for  */
+/*                a request after each stream: without a round trip   */
+/*                per stream the transfer is limited by the network   */
+/*                only. Streams requested before f_evt_get_close are  */
+/*                dropped. Also for the newer LMD format. With        */
+/*                l_depth > 0 the connection uses TCP_NODELAY, unless */
+/*                l_nodelay of f_evt_socket_options is -1.            */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_stream_depth(s_evt_channel *ps_chan, INTS4 l_depth)
+{
+   ps_chan->l_stream_depth = (l_depth > 0) ? l_depth : 0;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_stream_depth */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_socket_options                                */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_socket_options(s_evt_channel *ps_chan, ps_opt)*/
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Socket options of the connection to a server.       */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  ps_opt     : Options, see s_stcopt in f_stccomm.h. NULL: none    */
+/*                (default).                                          */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_socket_options(s_evt_channel *,         */
+/*                                           const struct s_stcopt *);*/
+/*+ FUNCTION    : Must be called before f_evt_get_open. The options   */
+/*                are copied and given to f_stc_connectopt for stream,*/
+/*                transport and event servers.                        */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_socket_options(s_evt_channel *ps_chan, const struct s_stcopt *ps_opt)
+{
+   if(ps_opt != NULL) ps_chan->s_stcopt = *ps_opt;
+   else memset(&ps_chan->s_stcopt, 0, sizeof(struct s_stcopt));
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_socket_options */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_lazy_swap                                     */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_lazy_swap(s_evt_channel *ps_chan, l_on)       */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Swap only the headers of events in other endian.    */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Address of channel structure.                       */
+/*+  l_on       : 1 headers only, 0 everything (default).             */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_lazy_swap(s_evt_channel *, INTS4);      */
+/*+ FUNCTION    : Must be called before f_evt_get_open. Files only.   */
+/*                f_evt_get_event swaps the buffer, event and         */
+/*                subevent headers, but not the subevent data, if     */
+/*                ps_chan->l_evt_swap is 1 after the call. The data   */
+/*                can then be swapped with f_evt_swap_data or while   */
+/*                it is copied, events dropped by the caller are      */
+/*                never swapped. Spanned events and events with       */
+/*                irregular subevents are swapped completely.         */
+/*                f_evt_get_buffer still swaps whole buffers.         */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_lazy_swap(s_evt_channel *ps_chan, INTS4 l_on)
+{
+   ps_chan->l_lazy_swap = l_on;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_lazy_swap */
+
+/*1+ C Main ****************+******************************************/
+/*+ Module      : f_evt_swap_data                                     */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_evt_swap_data(s_ve10_1 *ps_ve10_1)                */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Swap the subevent data of an event from             */
+/*                f_evt_get_event with ps_chan->l_evt_swap 1.         */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_ve10_1  : Event, the headers are already swapped.             */
+/*+ Return type : INTS4                                               */
+/*+ Declaration :                                                     */
+/*                INTS4 f_evt_swap_data(s_ve10_1 *);                  */
+/*+ FUNCTION    : Works in place, must be called once per event.      */
+/*1- C Main ****************+******************************************/
+INTS4 f_evt_swap_data(s_ve10_1 *ps_ve10_1)
+{
+   fLmdSwapSubeventData((sMbsEventHeader *)ps_ve10_1);
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_swap_data */
+
 /*1- C Main ****************+******************************************/
 /*+ Module      : f_evt_swap                                          */
 /*--------------------------------------------------------------------*/
@@ -1872,8 +2243,6 @@ INTS4 f_evt_timeout(s_evt_channel *ps_chan, INTS4 l_sec)
 /*1- C Procedure ***********+******************************************/
 INTS4 f_evt_swap(CHARS * pc_source, INTS4 l_length)
 {
-   CHARS * p_s, * p_d;
-   INTS4 l_save;
    CHARS ch_temp;
 
    if(l_length%4 == 2){
@@ -1881,16 +2250,7 @@ INTS4 f_evt_swap(CHARS * pc_source, INTS4 l_length)
       *(pc_source+l_length-2)=*(pc_source+l_length-1);
       *(pc_source+l_length-1)=ch_temp;
    }
-   l_length=(l_length/4)*4;       /* aligned */
-   for(p_d=pc_source,p_s=(CHARS *)&l_save; p_d<pc_source+l_length;)
-   {
-      l_save = *((INTS4 *)p_d);
-      p_s += 4;                 /* increment source               */
-      *(p_d++) = *(--p_s);
-      *(p_d++) = *(--p_s);
-      *(p_d++) = *(--p_s);
-      *(p_d++) = *(--p_s);
-   }
+   if(l_length >= 4) f_ut_swap4(pc_source,l_length/4,NULL);
    return(0);
 } /* end of f_evt_swap */
 /*1- C Main ****************+******************************************/
@@ -1934,6 +2294,60 @@ INTS4 f_evt_swap_filhe(s_bufhe *ps_bufhe)
       return(0);
     } /* end of f_evt_swap */
 
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_swap_lazy                                     */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Swap the events of the buffer ps_chan->ps_bufhe,    */
+/*                whose header is already swapped.                    */
+/*+ ARGUMENTS   :                                                     */
+/*+  ps_chan    : Channel, l_buf_posi is the begin of the data.       */
+/*+  l_used     : Bytes of events in the buffer.                      */
+/*+ FUNCTION    : Events whose subevents fit exactly get only the     */
+/*                event and subevent headers swapped, they are marked */
+/*                by l_lazy_begin and l_lazy_end. Fragments of        */
+/*                spanned events, irregular events and everything     */
+/*                behind them are swapped completely, like the whole  */
+/*                buffer without lazy swapping.                       */
+/*1- C Procedure *************+****************************************/
+void f_evt_swap_lazy(s_evt_channel *ps_chan, INTS4 l_used)
+{
+   CHARS *pc_data=ps_chan->pc_io_buf+ps_chan->l_buf_posi;
+   INTS4 l_data=ps_chan->l_buf_size-sizeof(s_bufhe);
+   INTS4 l_begin=0, l_posi=0, l_done=0, l_len, l_dlen;
+
+   if(l_used > l_data) l_used=l_data;
+   /* the buffer starts with the rest of a spanned event. f_evt_get_event also takes
+      it as a fragment when a spanned event is in progress and h_end is missing */
+   if((ps_chan->ps_bufhe->h_end == 1)||(ps_chan->l_evt_buf_posi != 0))
+   {
+      memcpy(&l_dlen,pc_data,4);
+      f_evt_swap((CHARS *)&l_dlen,4);
+      l_len=l_dlen*2+sizeof(s_evhe);
+      if((l_dlen >= 0)&&((l_dlen&1) == 0)&&(l_len <= l_used)) l_begin=l_len;
+      else l_used=0;
+   }
+   l_posi=l_begin;
+   while(l_posi+(INTS4)sizeof(s_ve10_1) <= l_used)
+   {
+      memcpy(&l_dlen,pc_data+l_posi,4);
+      f_evt_swap((CHARS *)&l_dlen,4);
+      l_len=l_dlen*2+sizeof(s_evhe);
+      if((l_dlen < 4)||(l_dlen&1)||(l_len > l_used-l_posi)) break;
+      if((ps_chan->ps_bufhe->h_begin == 1)&&(l_posi+l_len >= l_used)) break; /* begin of a spanned event */
+      f_evt_swap(pc_data+l_posi,sizeof(s_ve10_1));
+      if(fLmdSwapSubeventHeaders((sMbsEventHeader *)(pc_data+l_posi)) == 0)
+      {
+         l_done=sizeof(s_ve10_1); /* this event is swapped completely */
+         break;
+      }
+      l_posi+=l_len;
+   }
+   ps_chan->l_lazy_begin=ps_chan->l_buf_posi+l_begin;
+   ps_chan->l_lazy_end=ps_chan->l_buf_posi+l_posi;
+   if(l_begin > 0) f_evt_swap(pc_data,l_begin);
+   f_evt_swap(pc_data+l_posi+l_done,l_data-l_posi-l_done);
+} /* end of f_evt_swap_lazy */
+
 /*1- C Main ****************+******************************************/
 /*+ Module      : f_evt_get_buffer_ptr                                    */
 /*--------------------------------------------------------------------*/
@@ -1972,37 +2386,70 @@ INTS4 f_evt_get_newbuf(s_evt_channel *ps_chan)
    INTS4 l_temp;
    CHARS * pc_temp;
    INTS4 l_status;
-
-   pc_temp=(CHARS *)ps_chan->pc_io_buf;
+   off_t l_posi;
 
    // sometimes l_channel_no is = -1. that leads to a crash.
    if(ps_chan->l_channel_no < 0)
        return GETEVT__RDERR;
 
+   pc_temp=(CHARS *)ps_chan->pc_io_buf;
+
    switch(ps_chan->l_server_type)
    {
    case GETEVT__FILE :
-     while(1){
-      l_temp=read(ps_chan->l_channel_no,pc_temp, ps_chan->l_io_buf_size);
-      if(l_temp == 0)                    return(GETEVT__NOMORE);
-      if(l_temp == -1)                   return(GETEVT__RDERR);
-      if(l_temp < ps_chan->l_io_buf_size)return(GETEVT__RDERR);
-      break; /* skip out while(1) */
-     } /* end of while(1) */
+#ifdef Linux
+     if(ps_chan->pc_map != NULL)
+     {
+       /* the file offset stays the read position, f_evt_skip_buffer and f_evt_get_buffer use it */
+       ps_chan->pc_io_buf=ps_chan->pc_read_buf;
+       pc_temp=ps_chan->pc_io_buf;
+       l_posi=lseek(ps_chan->l_channel_no,0,SEEK_CUR);
+       /* whole buffers up to the block size */
+       l_temp=0;
+       if((l_posi >= 0)&&((lmdoff_t)l_posi < ps_chan->l_map_size))
+       {
+         l_temp=ps_chan->l_io_buf_max;
+         if(ps_chan->l_map_size-(lmdoff_t)l_posi < (lmdoff_t)l_temp)
+           l_temp=((ps_chan->l_map_size-l_posi)/ps_chan->l_buf_size)*ps_chan->l_buf_size;
+       }
+       if(l_temp > 0)
+       {
+         ps_chan->l_io_buf_size=l_temp;
+         lseek(ps_chan->l_channel_no,l_posi+l_temp,SEEK_SET);
+         if((lmdoff_t)(l_posi+l_temp) > ps_chan->l_map_advised) f_evt_map_advise(ps_chan,l_posi);
+         if( (((s_bufhe *)(ps_chan->pc_map+l_posi))->l_free[0] == 1)||(ps_chan->l_io_buf_raw == 1) )
+         {
+           ps_chan->pc_io_buf=ps_chan->pc_map+l_posi; /* no copy */
+           return(GETEVT__SUCCESS);
+         }
+         memcpy(pc_temp,ps_chan->pc_map+l_posi,l_temp); /* swapped below */
+         break;
+       }
+       /* behind the mapping, the file may have grown since open: read */
+     }
+#endif
+     l_temp=f_evt_read_block(ps_chan);
+     if(l_temp == 0)                    return(GETEVT__NOMORE);
+     if(l_temp == -1)                   return(GETEVT__RDERR);
+     if(l_temp < ps_chan->l_buf_size)   return(GETEVT__RDERR);
      break;
    case GETEVT__STREAM :
-      if(f_stc_write("GETEVT", 12, ps_chan->l_channel_no)!=STC__SUCCESS)
+      /* the request may have been sent with the previous stream */
+      if(ps_chan->l_stream_pending == 0)
       {
-         return(GETEVT__FAILURE);
+         if(f_stc_write("GETEVT", 12, ps_chan->l_channel_no)!=STC__SUCCESS)
+         {
+            return(GETEVT__FAILURE);
+         }
+         ps_chan->l_stream_pending=1;
       }
 
-      for(l_temp=0; l_temp<ps_chan->l_bufs_in_stream; l_temp++)
-      {
-         l_status=f_stc_read(pc_temp, ps_chan->l_buf_size, ps_chan->l_channel_no,ps_chan->l_timeout);
-         if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
-         if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
-         pc_temp+=ps_chan->l_buf_size;
-      }
+      /* the whole stream at once, the buffers are contiguous */
+      l_status=f_stc_recv(&ps_chan->s_tcpcomm, pc_temp, ps_chan->l_buf_size*ps_chan->l_bufs_in_stream, ps_chan->l_timeout);
+      if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
+      if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
+      ps_chan->l_stream_pending--;
+      f_evt_stream_request(ps_chan);
  	 l_temp=((s_bufhe *)(ps_chan->pc_io_buf))->l_evt;
       if( ((s_bufhe *)(ps_chan->pc_io_buf))->l_free[0] !=1) // swap
      	 f_evt_swap((CHARS *)&l_temp,4);
@@ -2015,7 +2462,10 @@ INTS4 f_evt_get_newbuf(s_evt_channel *ps_chan)
       if( ((s_bufhe *)(ps_chan->pc_io_buf))->l_evt == 0) return(GETEVT__TIMEOUT);
       break;
    case GETEVT__TRANS  :
-         l_status=f_stc_read(pc_temp, ps_chan->l_buf_size, ps_chan->l_channel_no,ps_chan->l_timeout);
+         /* one whole buffer per read, the server sends the next ones without request */
+         l_status=f_stc_recv(&ps_chan->s_tcpcomm, pc_temp, ps_chan->l_buf_size, ps_chan->l_timeout);
+         if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
+         if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
     	 l_temp=((s_bufhe *)(ps_chan->pc_io_buf))->l_evt;
          if( ((s_bufhe *)(ps_chan->pc_io_buf))->l_free[0] !=1) // swap
         	 f_evt_swap((CHARS *)&l_temp,4);
@@ -2024,8 +2474,6 @@ INTS4 f_evt_get_newbuf(s_evt_channel *ps_chan)
         	 f_evt_get_close(ps_chan);
         	 return(GETEVT__RDERR);
          }
-         if(l_status == STC__TIMEOUT) return(GETEVT__TIMEOUT);
-         if(l_status != STC__SUCCESS) return(GETEVT__RDERR);
       break;
    case GETEVT__RFIO     :
       l_temp=RFIO_read(ps_chan->l_channel_no,pc_temp, ps_chan->l_io_buf_size);
@@ -2039,12 +2487,199 @@ INTS4 f_evt_get_newbuf(s_evt_channel *ps_chan)
       return(GETEVT__FAILURE);
    }    /* end of switch */
 
+   ps_chan->l_io_buf_lazy=0;
+   if(ps_chan->l_io_buf_raw == 1) return(GETEVT__SUCCESS); /* f_evt_get_block */
    if( ((s_bufhe *)(ps_chan->pc_io_buf))->l_free[0] !=1) // swap
-      f_evt_swap(ps_chan->pc_io_buf, ps_chan->l_io_buf_size);
+   {
+      if(ps_chan->l_lazy_swap == 1)
+      {
+         /* buffer headers only, f_evt_get_event swaps the events of each buffer it enters */
+         for(l_temp=0; l_temp+ps_chan->l_buf_size <= ps_chan->l_io_buf_size; l_temp+=ps_chan->l_buf_size)
+            f_evt_swap(ps_chan->pc_io_buf+l_temp, sizeof(s_bufhe));
+         ps_chan->l_io_buf_lazy=1;
+      }
+      else f_evt_swap(ps_chan->pc_io_buf, ps_chan->l_io_buf_size);
+   }
 
    return(GETEVT__SUCCESS);
 } /* end of f_evt_get_newbuf */
 
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_map_file                                      */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Map the whole file of an open channel. The file     */
+/*                offset is not changed.                              */
+/*+ Return type : GETEVT__SUCCESS, GETEVT__FAILURE when not mapped.   */
+/*1- C Procedure *************+****************************************/
+INTS4 f_evt_map_file(s_evt_channel *ps_chan)
+{
+#ifdef Linux
+   struct stat s_stat;
+   void *p_map;
+
+   if(fstat(ps_chan->l_channel_no,&s_stat) != 0) return(GETEVT__FAILURE);
+   if(s_stat.st_size <= 0) return(GETEVT__FAILURE);
+   /* private and writable, a caller may change the events */
+   p_map=mmap(NULL,s_stat.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,ps_chan->l_channel_no,0);
+   if(p_map == MAP_FAILED)
+   {
+      printf("f_evt_map_file: %s can not be mapped, use read\n",ps_chan->c_channel);
+      return(GETEVT__FAILURE);
+   }
+   madvise(p_map,s_stat.st_size,MADV_SEQUENTIAL);
+   ps_chan->pc_map=(CHARS *)p_map;
+   ps_chan->l_map_size=s_stat.st_size;
+   ps_chan->l_map_advised=0;
+   ps_chan->pc_read_buf=ps_chan->pc_io_buf;
+   return(GETEVT__SUCCESS);
+#else
+   return(GETEVT__FAILURE);
+#endif
+} /* end of f_evt_map_file */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_map_advise                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Announce the next MAP__AHEAD bytes behind l_posi.   */
+/*1- C Procedure *************+****************************************/
+void f_evt_map_advise(s_evt_channel *ps_chan, lmdoff_t l_posi)
+{
+#ifdef Linux
+   lmdoff_t l_begin, l_end;
+   l_begin=l_posi & ~((lmdoff_t)sysconf(_SC_PAGESIZE)-1);
+   l_end=l_posi+MAP__AHEAD;
+   if(l_end > ps_chan->l_map_size) l_end=ps_chan->l_map_size;
+   if(l_end > l_begin) madvise(ps_chan->pc_map+l_begin,l_end-l_begin,MADV_WILLNEED);
+   ps_chan->l_map_advised=l_begin+MAP__AHEAD/2; /* next call in the middle of the range */
+#endif
+} /* end of f_evt_map_advise */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_unmap_file                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Remove the mapping, pc_io_buf is the buffer from    */
+/*                open again.                                         */
+/*1- C Procedure *************+****************************************/
+void f_evt_unmap_file(s_evt_channel *ps_chan)
+{
+   if(ps_chan->pc_map == NULL) return;
+#ifdef Linux
+   munmap(ps_chan->pc_map,ps_chan->l_map_size);
+#endif
+   ps_chan->pc_io_buf=ps_chan->pc_read_buf;
+   ps_chan->pc_map=NULL;
+   ps_chan->l_map_size=0;
+   ps_chan->pc_read_buf=NULL;
+} /* end of f_evt_unmap_file */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_read_block                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Read the next block of a file into the I/O buffer.  */
+/*                l_io_buf_size is set to the whole buffers read, the */
+/*                file offset is left behind the last whole buffer.   */
+/*+ Return type : Bytes read, 0 at end of file, -1 on read error.     */
+/*                A followed file ending in a partial buffer is at    */
+/*                its end, the buffer is read again by the next call. */
+/*1- C Procedure *************+****************************************/
+INTS4 f_evt_read_block(s_evt_channel *ps_chan)
+{
+   INTS4 l_temp, l_read;
+   CHARS *pc_block;
+   off_t l_posi;
+
+   if(ps_chan->p_read_ahead != NULL)
+   {
+      /* the block is used in place, the file offset follows the blocks taken */
+      l_posi=lseek(ps_chan->l_channel_no,0,SEEK_CUR);
+      l_read=f_ut_blkrd_get((s_blkrd *)ps_chan->p_read_ahead,l_posi,&pc_block);
+      if(l_read <= 0) return(l_read);
+      ps_chan->pc_io_buf=pc_block;
+      lseek(ps_chan->l_channel_no,l_posi+l_read,SEEK_SET);
+   }
+   else
+   {
+      l_read=0;
+      while(l_read < ps_chan->l_io_buf_max)
+      {
+         l_temp=read(ps_chan->l_channel_no,ps_chan->pc_io_buf+l_read,ps_chan->l_io_buf_max-l_read);
+         if(l_temp == -1) return(-1);
+         if(l_temp == 0) break;
+         l_read += l_temp;
+      }
+   }
+   if((l_read > 0)&&(l_read >= ps_chan->l_buf_size))
+   {
+      /* a partial buffer at the end is read again by the next call */
+      l_temp=l_read%ps_chan->l_buf_size;
+      if(l_temp > 0) lseek(ps_chan->l_channel_no,-l_temp,SEEK_CUR);
+      ps_chan->l_io_buf_size=l_read-l_temp;
+   }
+   else if((l_read > 0)&&(ps_chan->l_follow == 1))
+   {
+      /* the buffer is still written, read it again with the next call */
+      lseek(ps_chan->l_channel_no,-l_read,SEEK_CUR);
+      l_read=0;
+   }
+   return(l_read);
+} /* end of f_evt_read_block */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_ahead_start                                   */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Start the block reader of a file channel at the     */
+/*                current file offset, see f_ut_blkrd_open.           */
+/*+ Return type : GETEVT__SUCCESS, GETEVT__FAILURE when not started.  */
+/*1- C Procedure *************+****************************************/
+INTS4 f_evt_ahead_start(s_evt_channel *ps_chan)
+{
+   s_blkrd *ps_blkrd;
+
+   ps_blkrd=f_ut_blkrd_open(ps_chan->l_channel_no,ps_chan->l_io_buf_max,ps_chan->l_read_ahead,
+                            ps_chan->l_uring,lseek(ps_chan->l_channel_no,0,SEEK_CUR));
+   if(ps_blkrd == NULL)
+   {
+      printf("f_evt_ahead_start: no read-ahead for %s\n",ps_chan->c_channel);
+      return(GETEVT__FAILURE);
+   }
+   if((ps_chan->l_uring == 1)&&(f_ut_blkrd_uring(ps_blkrd) == 0))
+      printf("f_evt_ahead_start: io_uring not available, read %s with pread\n",ps_chan->c_channel);
+   ps_chan->p_read_ahead=ps_blkrd;
+   ps_chan->pc_read_buf=ps_chan->pc_io_buf;
+   return(GETEVT__SUCCESS);
+} /* end of f_evt_ahead_start */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_stream_request                                */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Send GETEVT requests until l_stream_depth requests  */
+/*                are outstanding, see f_evt_stream_depth. A failed   */
+/*                request is reported by the next read.               */
+/*1- C Procedure *************+****************************************/
+void f_evt_stream_request(s_evt_channel *ps_chan)
+{
+   while(ps_chan->l_stream_pending < ps_chan->l_stream_depth)
+   {
+      if(f_stc_write("GETEVT", 12, ps_chan->l_channel_no)!=STC__SUCCESS) return;
+      ps_chan->l_stream_pending++;
+   }
+} /* end of f_evt_stream_request */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_evt_ahead_stop                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Stop the block reader, before the file is closed.   */
+/*                pc_io_buf is the buffer from open again.            */
+/*1- C Procedure *************+****************************************/
+void f_evt_ahead_stop(s_evt_channel *ps_chan)
+{
+   if(ps_chan->p_read_ahead == NULL) return;
+   f_ut_blkrd_close((s_blkrd *)ps_chan->p_read_ahead);
+   ps_chan->p_read_ahead=NULL;
+   ps_chan->pc_io_buf=ps_chan->pc_read_buf;
+   ps_chan->pc_read_buf=NULL;
+} /* end of f_evt_ahead_stop */
+
 /*1- C Main ****************+******************************************/
 /*+ Module      : f_evt_check_buf                                     */
 /*--------------------------------------------------------------------*/
@@ -2240,6 +2875,7 @@ INTS4 f_evt_cre_tagfile(CHARS *pc_lmd, CHARS *pc_tag,INTS4 (*e_filter)())
   s_bufhe *ps_bufhe;
   s_taghe s_taghe;
   s_tag s_tag;
+  CHARS c_temp[MAX_BUF_LGTH];
 
   ps_bufhe = (s_bufhe *)c_temp;
   printf("LMD file %s, TAG file %s\n",pc_lmd,pc_tag);
@@ -2552,8 +3188,8 @@ INTS4 f_evt_get_tagopen(s_evt_channel *ps_chan,CHARS *pc_tag,CHARS *pc_lmd, CHAR
       return(GETEVT__NOFILE);
     }
   /* read buffer header to check if we have to swap */
-  ps_bufhe  = (s_bufhe  *)c_temp;
-  if(read(ps_chan->l_channel_no,c_temp,ps_chan->ps_taghe->l_bufsize)!=ps_chan->ps_taghe->l_bufsize)
+  ps_bufhe  = (s_bufhe  *)ps_chan->c_head;
+  if(read(ps_chan->l_channel_no,ps_chan->c_head,ps_chan->ps_taghe->l_bufsize)!=ps_chan->ps_taghe->l_bufsize)
     {
       if(ps_chan->ps_taghe != NULL) free(ps_chan->ps_taghe);
       ps_chan->ps_taghe = NULL;
@@ -2704,8 +3340,8 @@ INTS4 f_evt_get_tagevent(s_evt_channel *ps_chan,INTS4 l_value, INTS4 l_type, INT
       return(GETEVT__SUCCESS);
     }
   /*=============================================*/
-  ps_ve10_1 = (s_ve10_1 *)c_temp;
-  ps_bufhe  = (s_bufhe  *)c_temp;
+  ps_ve10_1 = (s_ve10_1 *)ps_chan->c_head;
+  ps_bufhe  = (s_bufhe  *)ps_chan->c_head;
 
   /* linear==1 means that event numbers are subsequent. */
   /* in that case we can calculate index from number */
@@ -2754,20 +3390,20 @@ INTS4 f_evt_get_tagevent(s_evt_channel *ps_chan,INTS4 l_value, INTS4 l_type, INT
   /* full event in buffer, read */
   if(ps_tag->l_offset > 0)
     {
-      ps_ve10_1 = (s_ve10_1 *)c_temp;
+      ps_ve10_1 = (s_ve10_1 *)ps_chan->c_head;
       lseek(ps_chan->l_channel_no, l_off, SEEK_SET);  /* set file offset*/
-      if(read(ps_chan->l_channel_no,c_temp,8)!=8) return(GETEVT__RDERR);
-      if(ps_chan->l_lmdswap)f_evt_swap(c_temp,8);
-      if(read(ps_chan->l_channel_no,(CHARS *)&c_temp[8],ps_ve10_1->l_dlen*2)!=ps_ve10_1->l_dlen*2)return(GETEVT__RDERR);
-      if(ps_chan->l_lmdswap)f_evt_swap((CHARS *)&c_temp[8],ps_ve10_1->l_dlen*2);
+      if(read(ps_chan->l_channel_no,ps_chan->c_head,8)!=8) return(GETEVT__RDERR);
+      if(ps_chan->l_lmdswap)f_evt_swap(ps_chan->c_head,8);
+      if(read(ps_chan->l_channel_no,(CHARS *)&ps_chan->c_head[8],ps_ve10_1->l_dlen*2)!=ps_ve10_1->l_dlen*2)return(GETEVT__RDERR);
+      if(ps_chan->l_lmdswap)f_evt_swap((CHARS *)&ps_chan->c_head[8],ps_ve10_1->l_dlen*2);
       /*ii=f_evt_type(NULL,(s_evhe *)ps_ve10_1,-1,0,1,1);*/
     }
   else
     /* spanning event begin, read to event buffer */
     {
       lseek(ps_chan->l_channel_no, l_off, SEEK_SET);  /* set file offset to buffer begin */
-      if(read(ps_chan->l_channel_no,c_temp,sizeof(s_bufhe))!=sizeof(s_bufhe)) return(GETEVT__RDERR);
-      if(ps_chan->l_lmdswap)f_evt_swap(c_temp,sizeof(s_bufhe));
+      if(read(ps_chan->l_channel_no,ps_chan->c_head,sizeof(s_bufhe))!=sizeof(s_bufhe)) return(GETEVT__RDERR);
+      if(ps_chan->l_lmdswap)f_evt_swap(ps_chan->c_head,sizeof(s_bufhe));
       /* is event buffer big enough? */
       l_evsize=ps_bufhe->l_free[1]+4; /* total words */
       if(ps_chan->l_evt_buf_size < l_evsize*2)
@@ -95,6 +95,31 @@ typedef struct
    s_taghe  *ps_taghe;
    s_tag    *ps_tag;
    sLmdControl *pLmd;
+   INTS4    l_mmap;           /* 1: map files, see f_evt_file_mmap */
+   CHARS    *pc_map;          /* mapping of the whole file        */
+   lmdoff_t l_map_size;       /* size of the mapping              */
+   lmdoff_t l_map_advised;    /* end of the range announced with MADV_WILLNEED */
+   CHARS    *pc_read_buf;     /* buffer from open, pc_io_buf may point into the mapping */
+   INTS4    l_file_block;     /* bytes per read of a file, see f_evt_file_block */
+   INTS4    l_read_ahead;     /* blocks of a file read ahead, 0: none */
+   INTS4    l_uring;          /* 1: read ahead with io_uring, see f_evt_file_uring */
+   INTS4    l_io_buf_max;     /* size of the I/O buffer, l_io_buf_size may be less at end of file */
+   void     *p_read_ahead;    /* block reader, see f_ut_blkrd.h   */
+   INTS4    l_lazy_swap;      /* 1: swap headers only, see f_evt_lazy_swap */
+   INTS4    l_io_buf_lazy;    /* 1: I/O buffer in other endian, buffer headers swapped */
+   INTS4    l_lazy_begin;     /* events in pc_io_buf from l_lazy_begin to l_lazy_end */
+   INTS4    l_lazy_end;       /* have only their headers swapped */
+   INTS4    l_evt_swap;       /* 1: subevent data of the last event still to be swapped */
+   INTS4    l_io_buf_raw;     /* 1: f_evt_get_newbuf leaves the buffers unswapped, see f_evt_get_block */
+   INTS4    l_follow;         /* 1: the file is still written, see f_evt_file_follow */
+   INTS4    l_follow_posi;    /* bytes of a spanned event read before the end of a followed file */
+   INTS4    l_stream_depth;   /* requests outstanding while a stream is decoded, see f_evt_stream_depth */
+   INTS4    l_stream_pending; /* requests sent whose stream is not read yet */
+   INTS4    l_port;           /* server port, 0: see f_evt_source_port */
+   struct s_tcpcomm s_tcpcomm; /* connection to a stream or transport server */
+   struct s_stcopt s_stcopt;   /* socket options of a server connection, see f_evt_socket_options */
+   void     *p_evcli;         /* connection to an event server, see f_evcli.c */
+   CHARS    c_head[MAX_BUF_LGTH]; /* file header from open, buffer of the tag functions */
 } s_evt_channel;
 
 INTS4 f_evt_cre_tagfile(CHARS *,CHARS *, INTS4 (*)());
@@ -106,6 +131,7 @@ INTS4 f_evt_get_open(INTS4, const CHARS *, s_evt_channel *, CHARS **, INTS4, INT
 INTS4 f_evt_get_event(s_evt_channel *, INTS4 **, INTS4 **);
 INTS4 f_evt_get_subevent(s_ve10_1 *,INTS4,INTS4 **,INTS4 **,INTS4 *);
 INTS4 f_evt_get_buffer(s_evt_channel *, INTS4 *);
+INTS4 f_evt_get_block(s_evt_channel *, CHARS **, INTS4 *, INTS4 *);
 INTS4 f_evt_get_close(s_evt_channel *);
 CHARS * f_evt_get_buffer_ptr(s_evt_channel *);
 INTS4 f_evt_skip_buffer(s_evt_channel *, INTS4);
@@ -116,7 +142,16 @@ INTS4 f_evt_put_close(s_evt_channel *);
 INTS4 f_evt_type(s_bufhe *,s_evhe *,INTS4,INTS4,INTS4,INTS4);
 INTS4 f_evt_error( INTS4 , CHARS * , INTS4 );
 INTS4 f_evt_timeout(s_evt_channel *, INTS4 );
+INTS4 f_evt_file_mmap(s_evt_channel *, INTS4);
+INTS4 f_evt_file_block(s_evt_channel *, INTS4, INTS4);
+INTS4 f_evt_file_uring(s_evt_channel *, INTS4);
+INTS4 f_evt_file_follow(s_evt_channel *, INTS4);
+INTS4 f_evt_stream_depth(s_evt_channel *, INTS4);
+INTS4 f_evt_socket_options(s_evt_channel *, const struct s_stcopt *);
+INTS4 f_evt_lazy_swap(s_evt_channel *, INTS4);
+INTS4 f_evt_swap_data(s_ve10_1 *);
 INTS4 f_evt_source_port(INTS4 l_port);
+INTS4 f_evt_server_port(s_evt_channel *, INTS4);
 INTS4 f_evt_rev_port(INTS4); /* obsolete */
 INTS4 f_evt_swap(CHARS *, INTS4);
 s_evt_channel * f_evt_control();
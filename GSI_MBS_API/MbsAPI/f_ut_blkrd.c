@@ -0,0 +1,626 @@
+// $Id$
+//-----------------------------------------------------------------------
+//       The GSI Online Offline Object Oriented (Go4) Project
+//         Experiment Data Processing at EE department, GSI
+//-----------------------------------------------------------------------
+// Copyright (C) 2000- GSI Helmholtzzentrum fr Schwerionenforschung GmbH
+//                     Planckstr. 1, 64291 Darmstadt, Germany
+// Contact:            http://go4.gsi.de
+//-----------------------------------------------------------------------
+// This software can be used under the license agreements as stated
+// in Go4License.txt file which is part of the distribution.
+//-----------------------------------------------------------------------
+
+#include "f_ut_blkrd.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef Linux
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define BLKRD__FREE 0
+#define BLKRD__BUSY 1  /* read submitted */
+#define BLKRD__DONE 2
+#define BLKRD__WAIT 3  /* read queued, not passed to the kernel, see f_ut_blkrd_uring_fail */
+
+typedef struct
+{
+   off_t    l_posi;        /* file offset of the block */
+   INTS4    l_bytes;       /* bytes read, -1 on read error */
+   INTS4    l_state;
+   struct iovec s_iov;
+} s_blkrd_slot;
+
+struct s_blkrd
+{
+   INTS4    l_fd;
+   INTS4    l_block;       /* bytes per block */
+   INTS4    l_slots;       /* blocks in flight + the block held by the caller */
+   INTS4    l_head;        /* next slot for the caller */
+   INTS4    l_tail;        /* next slot to submit */
+   INTS4    l_queued;      /* slots submitted and not yet taken */
+   off_t    l_next;        /* file offset of the next block to submit */
+   CHARS    *pc_mem;
+   s_blkrd_slot *ps_slot;
+   INTS4    l_uring;       /* 1: io_uring, 0: thread with pread, -1: no read ahead */
+   /* io_uring */
+   INTS4    l_ring_fd;
+   void     *p_sq_ring;
+   void     *p_cq_ring;
+   size_t   l_sq_bytes;
+   size_t   l_cq_bytes;
+   struct io_uring_sqe *ps_sqe;
+   size_t   l_sqe_bytes;
+   unsigned *pl_sq_head, *pl_sq_tail, *pl_sq_mask, *pl_sq_array;
+   unsigned *pl_cq_head, *pl_cq_tail, *pl_cq_mask;
+   struct io_uring_cqe *ps_cqe;
+   INTS4    l_to_submit;
+   /* thread */
+   pthread_t       thread;
+   pthread_mutex_t mutex;
+   pthread_cond_t  cond;
+   INTS4    l_thread_slot; /* next slot read by the thread */
+   INTS4    l_stop;
+};
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_pread                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Read l_size bytes at l_posi, less only at end of    */
+/*                file.                                               */
+/*+ Return type : Bytes read, -1 on read error.                       */
+/*1- C Procedure *************+****************************************/
+static INTS4 f_ut_blkrd_pread(INTS4 l_fd, CHARS *pc_buf, INTS4 l_size, off_t l_posi)
+{
+   INTS4 l_read=0;
+   ssize_t l_temp;
+
+   while(l_read < l_size)
+   {
+      l_temp=pread(l_fd,pc_buf+l_read,l_size-l_read,l_posi+l_read);
+      if((l_temp == -1)&&(errno == EINTR)) continue;
+      if(l_temp == -1) return(-1);
+      if(l_temp == 0) break;
+      l_read += l_temp;
+   }
+   return(l_read);
+} /* end of f_ut_blkrd_pread */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_uring_setup                              */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Create the io_uring with the raw system calls, no   */
+/*                liburing needed.                                    */
+/*+ Return type : 0 on success, -1 if io_uring is not available.      */
+/*1- C Procedure *************+****************************************/
+static INTS4 f_ut_blkrd_uring_setup(s_blkrd *ps_blkrd)
+{
+   struct io_uring_params s_par;
+   CHARS *pc_sq, *pc_cq;
+
+   memset(&s_par,0,sizeof(s_par));
+   ps_blkrd->l_ring_fd=(INTS4)syscall(__NR_io_uring_setup,(unsigned)ps_blkrd->l_slots,&s_par);
+   if(ps_blkrd->l_ring_fd < 0) return(-1); /* old kernel or not allowed */
+
+   ps_blkrd->l_sq_bytes=s_par.sq_off.array+s_par.sq_entries*sizeof(unsigned);
+   ps_blkrd->l_cq_bytes=s_par.cq_off.cqes+s_par.cq_entries*sizeof(struct io_uring_cqe);
+   if(s_par.features & IORING_FEAT_SINGLE_MMAP)
+   {
+      if(ps_blkrd->l_cq_bytes > ps_blkrd->l_sq_bytes) ps_blkrd->l_sq_bytes=ps_blkrd->l_cq_bytes;
+      ps_blkrd->l_cq_bytes=0;
+   }
+   ps_blkrd->p_sq_ring=mmap(NULL,ps_blkrd->l_sq_bytes,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                            ps_blkrd->l_ring_fd,IORING_OFF_SQ_RING);
+   if(ps_blkrd->p_sq_ring == MAP_FAILED) ps_blkrd->p_sq_ring=NULL;
+   ps_blkrd->p_cq_ring=ps_blkrd->p_sq_ring;
+   if((ps_blkrd->p_sq_ring != NULL)&&(ps_blkrd->l_cq_bytes > 0))
+   {
+      ps_blkrd->p_cq_ring=mmap(NULL,ps_blkrd->l_cq_bytes,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                               ps_blkrd->l_ring_fd,IORING_OFF_CQ_RING);
+      if(ps_blkrd->p_cq_ring == MAP_FAILED) ps_blkrd->p_cq_ring=NULL;
+   }
+   ps_blkrd->l_sqe_bytes=s_par.sq_entries*sizeof(struct io_uring_sqe);
+   ps_blkrd->ps_sqe=mmap(NULL,ps_blkrd->l_sqe_bytes,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                         ps_blkrd->l_ring_fd,IORING_OFF_SQES);
+   if(ps_blkrd->ps_sqe == MAP_FAILED) ps_blkrd->ps_sqe=NULL;
+   if((ps_blkrd->p_sq_ring == NULL)||(ps_blkrd->p_cq_ring == NULL)||(ps_blkrd->ps_sqe == NULL)) return(-1);
+
+   pc_sq=(CHARS *)ps_blkrd->p_sq_ring;
+   pc_cq=(CHARS *)ps_blkrd->p_cq_ring;
+   ps_blkrd->pl_sq_head =(unsigned *)(pc_sq+s_par.sq_off.head);
+   ps_blkrd->pl_sq_tail =(unsigned *)(pc_sq+s_par.sq_off.tail);
+   ps_blkrd->pl_sq_mask =(unsigned *)(pc_sq+s_par.sq_off.ring_mask);
+   ps_blkrd->pl_sq_array=(unsigned *)(pc_sq+s_par.sq_off.array);
+   ps_blkrd->pl_cq_head =(unsigned *)(pc_cq+s_par.cq_off.head);
+   ps_blkrd->pl_cq_tail =(unsigned *)(pc_cq+s_par.cq_off.tail);
+   ps_blkrd->pl_cq_mask =(unsigned *)(pc_cq+s_par.cq_off.ring_mask);
+   ps_blkrd->ps_cqe=(struct io_uring_cqe *)(pc_cq+s_par.cq_off.cqes);
+   return(0);
+} /* end of f_ut_blkrd_uring_setup */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_uring_free                               */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Remove the io_uring, also a partly created one.     */
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_uring_free(s_blkrd *ps_blkrd)
+{
+   if(ps_blkrd->ps_sqe != NULL) munmap(ps_blkrd->ps_sqe,ps_blkrd->l_sqe_bytes);
+   if((ps_blkrd->p_cq_ring != NULL)&&(ps_blkrd->p_cq_ring != ps_blkrd->p_sq_ring))
+      munmap(ps_blkrd->p_cq_ring,ps_blkrd->l_cq_bytes);
+   if(ps_blkrd->p_sq_ring != NULL) munmap(ps_blkrd->p_sq_ring,ps_blkrd->l_sq_bytes);
+   if(ps_blkrd->l_ring_fd >= 0) close(ps_blkrd->l_ring_fd);
+   ps_blkrd->ps_sqe=NULL;
+   ps_blkrd->p_cq_ring=NULL;
+   ps_blkrd->p_sq_ring=NULL;
+   ps_blkrd->l_ring_fd=-1;
+} /* end of f_ut_blkrd_uring_free */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_uring_enter                              */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Pass the queued reads to the kernel and wait for    */
+/*                l_wait completions.                                 */
+/*+ Return type : Result of io_uring_enter.                           */
+/*1- C Procedure *************+****************************************/
+static INTS4 f_ut_blkrd_uring_enter(s_blkrd *ps_blkrd, INTS4 l_wait)
+{
+   INTS4 l_temp;
+
+   do {
+      l_temp=(INTS4)syscall(__NR_io_uring_enter,ps_blkrd->l_ring_fd,(unsigned)ps_blkrd->l_to_submit,
+                            (unsigned)l_wait,l_wait > 0 ? IORING_ENTER_GETEVENTS : 0,NULL,0);
+   } while((l_temp == -1)&&(errno == EINTR));
+   if(l_temp > 0) ps_blkrd->l_to_submit -= l_temp;
+   if(ps_blkrd->l_to_submit < 0) ps_blkrd->l_to_submit=0;
+   return(l_temp);
+} /* end of f_ut_blkrd_uring_enter */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_uring_reap                               */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Mark the slots of all completed reads as done.      */
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_uring_reap(s_blkrd *ps_blkrd)
+{
+   unsigned l_head, l_tail;
+   struct io_uring_cqe *ps_cqe;
+   s_blkrd_slot *ps_slot;
+
+   l_head=*ps_blkrd->pl_cq_head;
+   l_tail=__atomic_load_n(ps_blkrd->pl_cq_tail,__ATOMIC_ACQUIRE);
+   while(l_head != l_tail)
+   {
+      ps_cqe=&ps_blkrd->ps_cqe[l_head & *ps_blkrd->pl_cq_mask];
+      ps_slot=&ps_blkrd->ps_slot[ps_cqe->user_data];
+      ps_slot->l_bytes=ps_cqe->res < 0 ? -1 : ps_cqe->res;
+      ps_slot->l_state=BLKRD__DONE;
+      l_head++;
+   }
+   __atomic_store_n(ps_blkrd->pl_cq_head,l_head,__ATOMIC_RELEASE);
+} /* end of f_ut_blkrd_uring_reap */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_run                                      */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Thread without io_uring, reads the submitted slots  */
+/*                in order with pread.                                */
+/*1- C Procedure *************+****************************************/
+static void *f_ut_blkrd_run(void *p_arg)
+{
+   s_blkrd *ps_blkrd=(s_blkrd *)p_arg;
+   s_blkrd_slot *ps_slot;
+   INTS4 l_bytes;
+
+   pthread_mutex_lock(&ps_blkrd->mutex);
+   while(ps_blkrd->l_stop == 0)
+   {
+      ps_slot=&ps_blkrd->ps_slot[ps_blkrd->l_thread_slot];
+      if(ps_slot->l_state != BLKRD__BUSY)
+      {
+         pthread_cond_wait(&ps_blkrd->cond,&ps_blkrd->mutex);
+         continue;
+      }
+      /* the caller does not touch a busy slot */
+      pthread_mutex_unlock(&ps_blkrd->mutex);
+      l_bytes=f_ut_blkrd_pread(ps_blkrd->l_fd,ps_slot->s_iov.iov_base,ps_blkrd->l_block,ps_slot->l_posi);
+      pthread_mutex_lock(&ps_blkrd->mutex);
+      ps_slot->l_bytes=l_bytes;
+      ps_slot->l_state=BLKRD__DONE;
+      ps_blkrd->l_thread_slot=(ps_blkrd->l_thread_slot+1)%ps_blkrd->l_slots;
+      pthread_cond_broadcast(&ps_blkrd->cond);
+   }
+   pthread_mutex_unlock(&ps_blkrd->mutex);
+   return(NULL);
+} /* end of f_ut_blkrd_run */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_thread                                   */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Start the thread reading the slots from l_slot on.  */
+/*+ Return type : 0 on success, -1 if the thread can not be created.  */
+/*1- C Procedure *************+****************************************/
+static INTS4 f_ut_blkrd_thread(s_blkrd *ps_blkrd, INTS4 l_slot)
+{
+   pthread_mutex_init(&ps_blkrd->mutex,NULL);
+   pthread_cond_init(&ps_blkrd->cond,NULL);
+   ps_blkrd->l_thread_slot=l_slot;
+   if(pthread_create(&ps_blkrd->thread,NULL,f_ut_blkrd_run,ps_blkrd) != 0)
+   {
+      pthread_cond_destroy(&ps_blkrd->cond);
+      pthread_mutex_destroy(&ps_blkrd->mutex);
+      return(-1);
+   }
+   return(0);
+} /* end of f_ut_blkrd_thread */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_uring_fail                               */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Continue with the thread after a hard io_uring      */
+/*                error.                                              */
+/*+ FUNCTION    : Reads the kernel has taken may still complete into  */
+/*                their slots, so they are waited for before the ring */
+/*                is removed. Reads still queued in the ring are      */
+/*                passed to the thread. If the reads do not complete, */
+/*                the slots get new memory and the old one is not     */
+/*                freed. Without thread the blocks are not read ahead.*/
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_uring_fail(s_blkrd *ps_blkrd)
+{
+   unsigned l_head, l_tail;
+   INTS4 l_temp, l_pending, l_wait, l_slot;
+   CHARS *pc_mem;
+
+   l_head=__atomic_load_n(ps_blkrd->pl_sq_head,__ATOMIC_ACQUIRE);
+   l_tail=*ps_blkrd->pl_sq_tail;
+   for(;l_head != l_tail;l_head++)
+      ps_blkrd->ps_slot[ps_blkrd->ps_sqe[ps_blkrd->pl_sq_array[l_head & *ps_blkrd->pl_sq_mask]].user_data].l_state=BLKRD__WAIT;
+
+   for(l_wait=0;l_wait<5000;l_wait++) /* 5 s */
+   {
+      f_ut_blkrd_uring_reap(ps_blkrd);
+      l_pending=0;
+      for(l_temp=0;l_temp<ps_blkrd->l_slots;l_temp++)
+         if(ps_blkrd->ps_slot[l_temp].l_state == BLKRD__BUSY) l_pending++;
+      if(l_pending == 0) break;
+      usleep(1000);
+   }
+   if(l_pending > 0)
+   {
+      printf("f_ut_blkrd: %d io_uring reads do not complete, their blocks are dropped\n",l_pending);
+      pc_mem=(CHARS *)malloc((size_t)ps_blkrd->l_slots*ps_blkrd->l_block);
+      if(pc_mem == NULL) exit(2); /* like the other memory allocation errors of f_evt */
+      ps_blkrd->pc_mem=pc_mem; /* the old memory may still be written */
+      for(l_temp=0;l_temp<ps_blkrd->l_slots;l_temp++)
+      {
+         ps_blkrd->ps_slot[l_temp].s_iov.iov_base=pc_mem+(size_t)l_temp*ps_blkrd->l_block;
+         if(ps_blkrd->ps_slot[l_temp].l_state == BLKRD__BUSY)
+         {
+            ps_blkrd->ps_slot[l_temp].l_bytes=-1; /* read again with pread */
+            ps_blkrd->ps_slot[l_temp].l_state=BLKRD__DONE;
+         }
+      }
+   }
+   f_ut_blkrd_uring_free(ps_blkrd);
+   ps_blkrd->l_to_submit=0;
+
+   /* the queued reads follow the completed ones */
+   l_slot=ps_blkrd->l_tail;
+   for(l_temp=ps_blkrd->l_queued;l_temp>0;l_temp--)
+   {
+      if(ps_blkrd->ps_slot[(ps_blkrd->l_tail+ps_blkrd->l_slots-l_temp)%ps_blkrd->l_slots].l_state == BLKRD__WAIT)
+      {
+         l_slot=(ps_blkrd->l_tail+ps_blkrd->l_slots-l_temp)%ps_blkrd->l_slots;
+         break;
+      }
+   }
+   ps_blkrd->l_uring=0;
+   if(f_ut_blkrd_thread(ps_blkrd,l_slot) != 0) ps_blkrd->l_uring=-1;
+   for(l_temp=0;l_temp<ps_blkrd->l_slots;l_temp++)
+   {
+      if(ps_blkrd->ps_slot[l_temp].l_state != BLKRD__WAIT) continue;
+      ps_blkrd->ps_slot[l_temp].l_state=BLKRD__BUSY;
+      if(ps_blkrd->l_uring == -1)
+      {
+         ps_blkrd->ps_slot[l_temp].l_bytes=-1; /* read with pread by f_ut_blkrd_get */
+         ps_blkrd->ps_slot[l_temp].l_state=BLKRD__DONE;
+      }
+   }
+} /* end of f_ut_blkrd_uring_fail */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_submit                                   */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Submit reads of the next blocks into all free slots.*/
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_submit(s_blkrd *ps_blkrd)
+{
+   s_blkrd_slot *ps_slot;
+   struct io_uring_sqe *ps_sqe;
+   unsigned l_tail, l_index;
+
+   if(ps_blkrd->l_uring == 0) pthread_mutex_lock(&ps_blkrd->mutex);
+   while(ps_blkrd->l_queued < ps_blkrd->l_slots)
+   {
+      ps_slot=&ps_blkrd->ps_slot[ps_blkrd->l_tail];
+      ps_slot->l_posi=ps_blkrd->l_next;
+      ps_slot->l_bytes=0;
+      ps_slot->l_state=BLKRD__BUSY;
+      if(ps_blkrd->l_uring == -1)
+      {
+         ps_slot->l_bytes=-1; /* read with pread by f_ut_blkrd_get */
+         ps_slot->l_state=BLKRD__DONE;
+      }
+      if(ps_blkrd->l_uring == 1)
+      {
+         l_tail=*ps_blkrd->pl_sq_tail;
+         l_index=l_tail & *ps_blkrd->pl_sq_mask;
+         ps_sqe=&ps_blkrd->ps_sqe[l_index];
+         memset(ps_sqe,0,sizeof(struct io_uring_sqe));
+         ps_sqe->opcode=IORING_OP_READV; /* IORING_OP_READ needs 5.6 */
+         ps_sqe->fd=ps_blkrd->l_fd;
+         ps_sqe->addr=(unsigned long)&ps_slot->s_iov;
+         ps_sqe->len=1;
+         ps_sqe->off=ps_slot->l_posi;
+         ps_sqe->user_data=ps_blkrd->l_tail;
+         ps_blkrd->pl_sq_array[l_index]=l_index;
+         __atomic_store_n(ps_blkrd->pl_sq_tail,l_tail+1,__ATOMIC_RELEASE);
+         ps_blkrd->l_to_submit++;
+      }
+      ps_blkrd->l_next += ps_blkrd->l_block;
+      ps_blkrd->l_tail=(ps_blkrd->l_tail+1)%ps_blkrd->l_slots;
+      ps_blkrd->l_queued++;
+   }
+   if(ps_blkrd->l_uring == 0)
+   {
+      pthread_cond_broadcast(&ps_blkrd->cond);
+      pthread_mutex_unlock(&ps_blkrd->mutex);
+   }
+   else if((ps_blkrd->l_uring == 1)&&(ps_blkrd->l_to_submit > 0)) f_ut_blkrd_uring_enter(ps_blkrd,0);
+} /* end of f_ut_blkrd_submit */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_wait                                     */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Wait until the read of a slot is done.              */
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_wait(s_blkrd *ps_blkrd, s_blkrd_slot *ps_slot)
+{
+   if(ps_blkrd->l_uring == 1)
+   {
+      f_ut_blkrd_uring_reap(ps_blkrd);
+      while(ps_slot->l_state != BLKRD__DONE)
+      {
+         if((f_ut_blkrd_uring_enter(ps_blkrd,1) < 0)&&(errno != EAGAIN)&&(errno != EBUSY))
+         {
+            /* the slot is not touched while its read may be in flight */
+            f_ut_blkrd_uring_fail(ps_blkrd);
+            break;
+         }
+         f_ut_blkrd_uring_reap(ps_blkrd);
+      }
+      if(ps_blkrd->l_uring == 1) return;
+   }
+   if(ps_blkrd->l_uring == -1) return; /* all slots are done */
+   pthread_mutex_lock(&ps_blkrd->mutex);
+   while(ps_slot->l_state != BLKRD__DONE) pthread_cond_wait(&ps_blkrd->cond,&ps_blkrd->mutex);
+   pthread_mutex_unlock(&ps_blkrd->mutex);
+} /* end of f_ut_blkrd_wait */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_release                                  */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Take the slot at l_head out of the queue.           */
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_release(s_blkrd *ps_blkrd)
+{
+   if(ps_blkrd->l_uring == 0) pthread_mutex_lock(&ps_blkrd->mutex);
+   ps_blkrd->ps_slot[ps_blkrd->l_head].l_state=BLKRD__FREE;
+   if(ps_blkrd->l_uring == 0) pthread_mutex_unlock(&ps_blkrd->mutex);
+   ps_blkrd->l_head=(ps_blkrd->l_head+1)%ps_blkrd->l_slots;
+   ps_blkrd->l_queued--;
+} /* end of f_ut_blkrd_release */
+
+/*1+ C Procedure *************+****************************************/
+/*+ Module      : f_ut_blkrd_drain                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Wait for all submitted reads and drop the blocks.   */
+/*1- C Procedure *************+****************************************/
+static void f_ut_blkrd_drain(s_blkrd *ps_blkrd)
+{
+   s_blkrd_slot *ps_slot;
+
+   while(ps_blkrd->l_queued > 0)
+   {
+      ps_slot=&ps_blkrd->ps_slot[ps_blkrd->l_head];
+      f_ut_blkrd_wait(ps_blkrd,ps_slot);
+      f_ut_blkrd_release(ps_blkrd);
+   }
+} /* end of f_ut_blkrd_drain */
+#endif
+
+/*1+ C Main ******************+****************************************/
+/*+ Module      : f_ut_blkrd_open                                     */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_ut_blkrd_open(l_fd, l_block, l_depth, l_uring, l_posi) */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Start reading a file in blocks.                     */
+/*+ ARGUMENTS   :                                                     */
+/*+   l_fd      : File descriptor, its file offset is not used.       */
+/*+   l_block   : Bytes per block.                                    */
+/*+   l_depth   : Blocks read ahead of the block held by the caller.  */
+/*+   l_uring   : 1 read with io_uring, 0 or without io_uring: with a */
+/*                thread calling pread.                               */
+/*+   l_posi    : File offset of the first block.                     */
+/*+ Return type : Reader, NULL on failure (and on other systems than  */
+/*                Linux).                                             */
+/*+ FUNCTION    : The reads of l_depth blocks are submitted at once.  */
+/*                Each f_ut_blkrd_get returns the next block and      */
+/*                submits the read of a new one.                      */
+/*1- C Main ******************+****************************************/
+s_blkrd *f_ut_blkrd_open(INTS4 l_fd, INTS4 l_block, INTS4 l_depth, INTS4 l_uring, off_t l_posi)
+{
+#ifdef Linux
+   s_blkrd *ps_blkrd;
+   INTS4 l_temp;
+
+   if((l_block <= 0)||(l_depth <= 0)) return(NULL);
+   if((ps_blkrd=(s_blkrd *)malloc(sizeof(s_blkrd)))==NULL) return(NULL);
+   memset(ps_blkrd,0,sizeof(s_blkrd));
+   ps_blkrd->l_fd=l_fd;
+   ps_blkrd->l_block=l_block;
+   ps_blkrd->l_slots=l_depth+1;
+   ps_blkrd->l_next=l_posi;
+   ps_blkrd->l_ring_fd=-1;
+   ps_blkrd->pc_mem=(CHARS *)malloc((size_t)ps_blkrd->l_slots*l_block);
+   ps_blkrd->ps_slot=(s_blkrd_slot *)malloc(ps_blkrd->l_slots*sizeof(s_blkrd_slot));
+   if((ps_blkrd->pc_mem == NULL)||(ps_blkrd->ps_slot == NULL))
+   {
+      free(ps_blkrd->pc_mem);
+      free(ps_blkrd->ps_slot);
+      free(ps_blkrd);
+      return(NULL);
+   }
+   memset(ps_blkrd->ps_slot,0,ps_blkrd->l_slots*sizeof(s_blkrd_slot));
+   for(l_temp=0;l_temp<ps_blkrd->l_slots;l_temp++)
+   {
+      ps_blkrd->ps_slot[l_temp].s_iov.iov_base=ps_blkrd->pc_mem+(size_t)l_temp*l_block;
+      ps_blkrd->ps_slot[l_temp].s_iov.iov_len=l_block;
+   }
+
+   if(l_uring == 1)
+   {
+      if(f_ut_blkrd_uring_setup(ps_blkrd) == 0) ps_blkrd->l_uring=1;
+      else f_ut_blkrd_uring_free(ps_blkrd); /* use the thread */
+   }
+   if(ps_blkrd->l_uring == 0)
+   {
+      if(f_ut_blkrd_thread(ps_blkrd,0) != 0)
+      {
+         free(ps_blkrd->pc_mem);
+         free(ps_blkrd->ps_slot);
+         free(ps_blkrd);
+         return(NULL);
+      }
+   }
+   /* the caller holds no block yet, all slots are read */
+   f_ut_blkrd_submit(ps_blkrd);
+   return(ps_blkrd);
+#else
+   (void)l_fd; (void)l_block; (void)l_depth; (void)l_uring; (void)l_posi;
+   return(NULL);
+#endif
+} /* end of f_ut_blkrd_open */
+
+/*1+ C Main ******************+****************************************/
+/*+ Module      : f_ut_blkrd_get                                      */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_ut_blkrd_get(ps_blkrd, l_posi, &pc_block)         */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : Return the block at file offset l_posi.             */
+/*+ ARGUMENTS   :                                                     */
+/*+   ps_blkrd  : Reader from f_ut_blkrd_open.                        */
+/*+   l_posi    : File offset, normally behind the previous block.    */
+/*+  ppc_block  : Returns the address of the block, valid until the   */
+/*                next call. The caller may change the block.         */
+/*+ Return type : Bytes in the block, less than the block size only   */
+/*                at end of file, 0 at end of file, -1 on read error. */
+/*+ FUNCTION    : The previous block is released and read again with  */
+/*                the next block behind the blocks in flight. If      */
+/*                l_posi is not the offset of the next block, the     */
+/*                reads in flight are dropped and the reader starts   */
+/*                again at l_posi. Blocks that were read only partly  */
+/*                are completed with pread.                           */
+/*1- C Main ******************+****************************************/
+INTS4 f_ut_blkrd_get(s_blkrd *ps_blkrd, off_t l_posi, CHARS **ppc_block)
+{
+#ifdef Linux
+   s_blkrd_slot *ps_slot;
+   INTS4 l_bytes, l_temp;
+
+   /* e.g. a skip, or a short block at end of the file that has grown since */
+   if((ps_blkrd->l_queued == 0)||(ps_blkrd->ps_slot[ps_blkrd->l_head].l_posi != l_posi))
+   {
+      f_ut_blkrd_drain(ps_blkrd);
+      ps_blkrd->l_next=l_posi;
+   }
+   /* the previous block is not held anymore */
+   f_ut_blkrd_submit(ps_blkrd);
+
+   ps_slot=&ps_blkrd->ps_slot[ps_blkrd->l_head];
+   f_ut_blkrd_wait(ps_blkrd,ps_slot);
+   l_bytes=ps_slot->l_bytes;
+   if(l_bytes < 0) l_bytes=0; /* e.g. io_uring error, read again */
+   if(l_bytes < ps_blkrd->l_block)
+   {
+      l_temp=f_ut_blkrd_pread(ps_blkrd->l_fd,(CHARS *)ps_slot->s_iov.iov_base+l_bytes,
+                              ps_blkrd->l_block-l_bytes,l_posi+l_bytes);
+      if(l_temp < 0) l_bytes=-1;
+      else l_bytes += l_temp;
+   }
+   /* held by the caller until the next call */
+   f_ut_blkrd_release(ps_blkrd);
+   *ppc_block=(CHARS *)ps_slot->s_iov.iov_base;
+   return(l_bytes);
+#else
+   (void)ps_blkrd; (void)l_posi; (void)ppc_block;
+   return(-1);
+#endif
+} /* end of f_ut_blkrd_get */
+
+/*1+ C Main ******************+****************************************/
+/*+ Module      : f_ut_blkrd_uring                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Return 1, if the reader uses io_uring.              */
+/*1- C Main ******************+****************************************/
+INTS4 f_ut_blkrd_uring(s_blkrd *ps_blkrd)
+{
+#ifdef Linux
+   return(ps_blkrd->l_uring == 1);
+#else
+   (void)ps_blkrd;
+   return(0);
+#endif
+} /* end of f_ut_blkrd_uring */
+
+/*1+ C Main ******************+****************************************/
+/*+ Module      : f_ut_blkrd_close                                    */
+/*--------------------------------------------------------------------*/
+/*+ PURPOSE     : Wait for the reads in flight and free the reader.   */
+/*                The file is not closed.                             */
+/*1- C Main ******************+****************************************/
+void f_ut_blkrd_close(s_blkrd *ps_blkrd)
+{
+#ifdef Linux
+   if(ps_blkrd == NULL) return;
+   f_ut_blkrd_drain(ps_blkrd);
+   if(ps_blkrd->l_uring == 1) f_ut_blkrd_uring_free(ps_blkrd);
+   else if(ps_blkrd->l_uring == 0)
+   {
+      pthread_mutex_lock(&ps_blkrd->mutex);
+      ps_blkrd->l_stop=1;
+      pthread_cond_broadcast(&ps_blkrd->cond);
+      pthread_mutex_unlock(&ps_blkrd->mutex);
+      pthread_join(ps_blkrd->thread,NULL);
+      pthread_cond_destroy(&ps_blkrd->cond);
+      pthread_mutex_destroy(&ps_blkrd->mutex);
+   }
+   free(ps_blkrd->pc_mem);
+   free(ps_blkrd->ps_slot);
+   free(ps_blkrd);
+#else
+   (void)ps_blkrd;
+#endif
+} /* end of f_ut_blkrd_close */
@@ -0,0 +1,28 @@
+// $Id$
+//-----------------------------------------------------------------------
+//       The GSI Online Offline Object Oriented (Go4) Project
+//         Experiment Data Processing at EE department, GSI
+//-----------------------------------------------------------------------
+// Copyright (C) 2000- GSI Helmholtzzentrum fr Schwerionenforschung GmbH
+//                     Planckstr. 1, 64291 Darmstadt, Germany
+// Contact:            http://go4.gsi.de
+//-----------------------------------------------------------------------
+// This software can be used under the license agreements as stated
+// in Go4License.txt file which is part of the distribution.
+//-----------------------------------------------------------------------
+
+#ifndef F_UT_BLKRD_H
+#define F_UT_BLKRD_H
+
+#include <sys/types.h>
+#include "typedefs.h"
+
+/* sequential block reader, keeps several block reads of a file in flight */
+typedef struct s_blkrd s_blkrd;
+
+s_blkrd *f_ut_blkrd_open(INTS4 l_fd, INTS4 l_block, INTS4 l_depth, INTS4 l_uring, off_t l_posi);
+INTS4 f_ut_blkrd_get(s_blkrd *ps_blkrd, off_t l_posi, CHARS **ppc_block);
+INTS4 f_ut_blkrd_uring(s_blkrd *ps_blkrd);
+void  f_ut_blkrd_close(s_blkrd *ps_blkrd);
+
+#endif
@@ -16,6 +16,89 @@
 CHARS c_msg[80];
 /*#define DEBUG 1*/
 
+#ifdef GSI__LINUX
+/* set TCP_QUICKACK, the kernel clears it again */
+static void f_stc_quickack(INTS4 i_channel)
+{
+#ifdef TCP_QUICKACK
+   INTS4 l_val = 1;
+   setsockopt(i_channel, IPPROTO_TCP, TCP_QUICKACK, &l_val, sizeof(l_val));
+#endif
+}
+
+/* socket options of f_stc_connectopt before the connect, failures leave the default */
+static void f_stc_setopt(struct s_tcpcomm *ps_tcp, const struct s_stcopt *ps_opt)
+{
+   INTS4 l_val = 1;
+
+   if( ps_opt->l_rcvbuf > 0 )
+   {
+#ifdef SO_RCVBUFFORCE
+      /* beyond net.core.rmem_max, if privileged */
+      if( setsockopt(ps_tcp->socket, SOL_SOCKET, SO_RCVBUFFORCE, &ps_opt->l_rcvbuf, sizeof(INTS4)) == -1 )
+#endif
+      setsockopt(ps_tcp->socket, SOL_SOCKET, SO_RCVBUF, &ps_opt->l_rcvbuf, sizeof(INTS4));
+   }
+   if( ps_opt->l_nodelay != 0 )
+   {
+      INTS4 l_nodelay = (ps_opt->l_nodelay > 0) ? 1 : 0;
+      setsockopt(ps_tcp->socket, IPPROTO_TCP, TCP_NODELAY, &l_nodelay, sizeof(l_nodelay));
+   }
+#ifdef SO_BUSY_POLL
+   if( ps_opt->l_busy_poll > 0 )
+      setsockopt(ps_tcp->socket, SOL_SOCKET, SO_BUSY_POLL, &ps_opt->l_busy_poll, sizeof(INTS4));
+#endif
+   if( ps_opt->l_keepalive > 0 )
+   {
+      setsockopt(ps_tcp->socket, SOL_SOCKET, SO_KEEPALIVE, &l_val, sizeof(l_val));
+      setsockopt(ps_tcp->socket, IPPROTO_TCP, TCP_KEEPIDLE, &ps_opt->l_keepalive, sizeof(INTS4));
+      setsockopt(ps_tcp->socket, IPPROTO_TCP, TCP_KEEPINTVL, &ps_opt->l_keepalive, sizeof(INTS4));
+   }
+   ps_tcp->i_quickack = (ps_opt->l_quickack > 0) ? 1 : 0;
+}
+
+/* connect, waiting at most l_timeout seconds. returns as connect, with errno */
+static INTS4 f_stc_connect_wait(struct s_tcpcomm *ps_tcp, INTS4 l_timeout)
+{
+   INTS4         retval, l_flags, l_error;
+   socklen_t     l_len = sizeof(l_error);
+   struct pollfd s_poll;
+
+   l_flags = fcntl(ps_tcp->socket, F_GETFL, 0);
+   if( l_flags == -1 || fcntl(ps_tcp->socket, F_SETFL, l_flags | O_NONBLOCK) == -1 )
+      return connect(ps_tcp->socket, (struct sockaddr *) &ps_tcp->sock, sizeof(ps_tcp->sock));
+
+   retval = connect(ps_tcp->socket, (struct sockaddr *) &ps_tcp->sock, sizeof(ps_tcp->sock));
+   if( retval == -1 && errno == EINPROGRESS )
+   {
+      s_poll.fd     = ps_tcp->socket;
+      s_poll.events = POLLOUT;
+      do
+         retval = poll(&s_poll, 1, l_timeout*1000);
+      while( retval == -1 && errno == EINTR );
+      if( retval == 0 )
+      {
+         errno  = ETIMEDOUT;
+         retval = -1;
+      }
+      else if( retval > 0 )
+      {
+         retval = getsockopt(ps_tcp->socket, SOL_SOCKET, SO_ERROR, &l_error, &l_len);
+         if( retval == 0 && l_error != 0 )
+         {
+            errno  = l_error;
+            retval = -1;
+         }
+      }
+   }
+
+   l_error = errno;
+   fcntl(ps_tcp->socket, F_SETFL, l_flags);
+   errno = l_error;
+   return retval;
+}
+#endif
+
 /* %%+HEAD: */
 /*****************+***********+****************************************/
 /*                                                                    */
@@ -134,6 +217,10 @@ INTS4 f_stc_read(void *p_buffer, INTS4 i_buflen, INTS4 i_channel, INTS4 i_timeou
    struct timeval       read_timeout;
    fd_set               xrmask,xwmask,xemask;
    INTS4                num_of_bytes_read = 0;
+#ifdef GSI__LINUX
+   struct pollfd        s_poll;
+   INTS4                i_wait = 0;   /* 1: socket drained, see f_stc_epoll */
+#endif
 
    buflen_tmp        = i_buflen;
    p_buffer_tmp      = (INTS1*) p_buffer;            /* actual pointer to buffer      */
@@ -149,6 +236,31 @@ INTS4 f_stc_read(void *p_buffer, INTS4 i_buflen, INTS4 i_channel, INTS4 i_timeou
 #endif
    while( num_of_bytes_read < i_buflen &&  buflen_tmp > 0 )
    {
+#ifdef GSI__LINUX
+      /* poll has no limit like FD_SETSIZE of select for the channel number */
+      if( i_timeout >= 0 || i_wait )
+      {
+         i_wait = 0;
+         s_poll.fd      = i_channel;
+         s_poll.events  = POLLIN;
+         s_poll.revents = 0;
+         retval = poll(&s_poll, 1, (i_timeout >= 0) ? read_timeout.tv_sec*1000 : -1);
+         switch( retval )
+         {
+            case -1:
+               switch( errno )
+               {
+                  case EINTR      : continue;
+                  case EINVAL     : return STC__INVTIME;
+                  default         : sprintf(c_msg,"STC poll error channel %d",i_channel);
+                  perror(c_msg);
+                  return STC__FAILURE;
+               }
+                  case 0: return STC__TIMEOUT;
+         }
+         if( s_poll.revents & POLLNVAL ) return STC__INVSOCK;
+      }
+#else
       if( i_timeout >= 0 )
       {
          /*
@@ -179,6 +291,7 @@ INTS4 f_stc_read(void *p_buffer, INTS4 i_buflen, INTS4 i_channel, INTS4 i_timeou
                   case 0: return STC__TIMEOUT;
          }
       }
+#endif
       /* ------------------------------------------------------- */
       /*   read data from the connect socket.                    */
       /* ------------------------------------------------------- */
@@ -199,6 +312,10 @@ INTS4 f_stc_read(void *p_buffer, INTS4 i_buflen, INTS4 i_channel, INTS4 i_timeou
             case EINVAL     : return STC__NGBUFSIZE;
             case EINTR      : return STC__EINTR;
             case ECONNRESET : return STC__ECONNRES;
+#ifdef GSI__LINUX
+            case EAGAIN     : i_wait = 1; /* non-blocking socket */
+                              continue;
+#endif
             default         : sprintf(c_msg,"STC read error channel %d",i_channel);
                               perror(c_msg);
                               return STC__FAILURE;
@@ -315,6 +432,13 @@ INTS4 f_stc_read(void *p_buffer, INTS4 i_buflen, INTS4 i_channel, INTS4 i_timeou
 INTS4 f_stc_write(void *p_buffer, INTS4 i_buflen, INTS4 i_channel)
 {
    INTS4   l_retval;
+   INTS4   l_flags = 0;
+#ifdef GSI__LINUX
+   struct pollfd s_poll;
+#endif
+#ifdef MSG_NOSIGNAL
+   l_flags = MSG_NOSIGNAL; /* a peer that is gone is an error, not SIGPIPE */
+#endif
 
    /* ---------------------------------------------------------- */
    /*   send data to server.                                     */
@@ -323,7 +447,24 @@ INTS4 f_stc_write(void *p_buffer, INTS4 i_buflen, INTS4 i_channel)
 #ifdef DEBUG
    printf("STC: write %5d bytes channel %d ",i_buflen,i_channel);fflush(stdout);
 #endif
-   l_retval = send(i_channel , p_buffer , i_buflen , 0);
+   l_retval = send(i_channel , p_buffer , i_buflen , l_flags);
+#ifdef GSI__LINUX
+   /* non-blocking socket, see f_stc_epoll: wait until the rest fits */
+   while( (l_retval == -1 && (errno == EAGAIN || errno == EINTR)) ||
+          (l_retval > 0 && l_retval < i_buflen) )
+   {
+      if( l_retval > 0 )
+      {
+         p_buffer  = (INTS1 *) p_buffer + l_retval;
+         i_buflen -= l_retval;
+      }
+      s_poll.fd      = i_channel;
+      s_poll.events  = POLLOUT;
+      s_poll.revents = 0;
+      if( l_retval == -1 && errno == EAGAIN ) poll(&s_poll, 1, -1);
+      l_retval = send(i_channel , p_buffer , i_buflen , l_flags);
+   }
+#endif
 
    switch( l_retval )
    {
@@ -333,6 +474,8 @@ INTS4 f_stc_write(void *p_buffer, INTS4 i_buflen, INTS4 i_channel)
             case EBADF    : return STC__INVSOCK;
             case ENOTSOCK : return STC__NOTSOCK;
             case EFAULT   : return STC__INVADDR;
+            case EPIPE    :
+            case ECONNRESET : return STC__ECONNRES;
             default       : sprintf(c_msg,"STC write error channel %d",i_channel);
             perror(c_msg);
             return STC__FAILURE;
@@ -353,6 +496,255 @@ INTS4 f_stc_write(void *p_buffer, INTS4 i_buflen, INTS4 i_channel)
 }  /* end f_stc_write()  */
 
 
+/* %%+HEAD: */
+/*****************+***********+****************************************/
+/*                                                                    */
+/*1+ PLI Main ****************+****************************************/
+/*                                                                    */
+/*+ Module      : f_stc_epoll                                         */
+/*                                                                    */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_stc_epoll( struct s_tcpcomm ps_tcp )              */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : f_stc_epoll. read a connected socket with epoll.    */
+/*                                                                    */
+/*+ ARGUMENTS   :                                                     */
+/*                                                                    */
+/*+ ps_tcp      : Pointer to structure s_tcpcomm from                 */
+/*                f_stc_connectserver.                                */
+/*                                                                    */
+/*+ FUNCTION    : The socket is made non-blocking and registered edge */
+/*                triggered in an epoll instance of its own. Then     */
+/*                f_stc_recv reads as much as the socket holds with   */
+/*                each recv and waits in epoll only when the socket   */
+/*                is drained. There is no limit like FD_SETSIZE of    */
+/*                select for the channel number. f_stc_read and       */
+/*                f_stc_write still work on the channel. The epoll    */
+/*                instance is closed by f_stc_close.                  */
+/*                                                                    */
+/*+ REMARKS     : Linux only, elsewhere STC__FAILURE is returned and  */
+/*                f_stc_recv calls f_stc_read.                        */
+/*                                                                    */
+/*2+IMPLEMENTATION************+****************************************/
+/*                                                                    */
+/*+ Return type : INTEGER                                             */
+/*+ Status codes:                                                     */
+/*-        STC__SUCCESS : success.                             */
+/*-        STC__FAILURE : failure, the socket is unchanged.    */
+/*                                                                    */
+/*1- PLI Main ****************+****************************************/
+/* %%-HEAD: */
+
+INTS4 f_stc_epoll(struct s_tcpcomm *ps_tcp)
+{
+#ifdef GSI__LINUX
+   struct epoll_event s_event;
+   INTS4              l_flags;
+
+   if( ps_tcp->i_epoll > 0 ) return STC__SUCCESS;
+
+   l_flags = fcntl(ps_tcp->socket, F_GETFL, 0);
+   if( l_flags == -1 ) return STC__FAILURE;
+
+   ps_tcp->i_epoll = epoll_create1(EPOLL_CLOEXEC);
+   if( ps_tcp->i_epoll == -1 )
+   {
+      ps_tcp->i_epoll = 0;
+      return STC__FAILURE;
+   }
+
+   memset(&s_event, 0, sizeof(s_event));
+   s_event.events  = EPOLLIN | EPOLLRDHUP | EPOLLET;
+   s_event.data.fd = ps_tcp->socket;
+   if( epoll_ctl(ps_tcp->i_epoll, EPOLL_CTL_ADD, ps_tcp->socket, &s_event) == -1 ||
+       fcntl(ps_tcp->socket, F_SETFL, l_flags | O_NONBLOCK) == -1 )
+   {
+      close(ps_tcp->i_epoll);
+      ps_tcp->i_epoll = 0;
+      return STC__FAILURE;
+   }
+   return STC__SUCCESS;
+#else
+   return STC__FAILURE;
+#endif
+} /* f_stc_epoll()  */
+
+
+/* %%+HEAD: */
+/*****************+***********+****************************************/
+/*                                                                    */
+/*1+ PLI Main ****************+****************************************/
+/*                                                                    */
+/*+ Module      : f_stc_recv                                          */
+/*                                                                    */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_stc_recv( struct s_tcpcomm ps_tcp , INTS1 p_buffer , */
+/*                            INTS4 i_buflen , INTS4 i_timeout )      */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : f_stc_recv. read bytes from a connected socket      */
+/*                            and places them in a buffer (p_buffer). */
+/*                                                                    */
+/*+ ARGUMENTS   :                                                     */
+/*                                                                    */
+/*+ ps_tcp      : Pointer to structure s_tcpcomm.                     */
+/*                                                                    */
+/*+ p_buffer    : Pointer to free data buffer.                        */
+/*                                                                    */
+/*+ i_buflen    : buffer length.                                      */
+/*                                                                    */
+/*+ i_timeout   : Timeout value ( seconds ) as for f_stc_read.        */
+/*                                                                    */
+/*+ FUNCTION    : As f_stc_read, but after f_stc_epoll the socket is  */
+/*                read directly into p_buffer until it is drained and */
+/*                only then waited for in epoll. Without f_stc_epoll  */
+/*                f_stc_read is called.                               */
+/*                                                                    */
+/*2+IMPLEMENTATION************+****************************************/
+/*                                                                    */
+/*+ Return type : INTEGER                                             */
+/*+ Status codes:                                                     */
+/*-        STC__SUCCESS   : success.                           */
+/*-        STC__FAIlURE   : failure.                           */
+/*-        STC__INVSOCK   : invalid socket number.             */
+/*-        STC__INVBUF    : buffer points outside allocated    */
+/*                                  adress space.                     */
+/*-        STC__NGBUFSIZE : buffer length is negative.         */
+/*-        STC__TIMEOUT   : timeout read from socket.          */
+/*-        STC__ECONNRES  : connection closed by the server.   */
+/*                                                                    */
+/*1- PLI Main ****************+****************************************/
+/* %%-HEAD: */
+
+INTS4 f_stc_recv(struct s_tcpcomm *ps_tcp, void *p_buffer, INTS4 i_buflen, INTS4 i_timeout)
+{
+#ifdef GSI__LINUX
+   INTS4                retval , buflen_tmp;
+   INTS1               *p_buffer_tmp;
+   INTS4                i_wait;
+   struct epoll_event   s_event;
+
+   /* the kernel leaves quick ack mode by itself */
+   if( ps_tcp->i_quickack == 1 ) f_stc_quickack(ps_tcp->socket);
+   if( ps_tcp->i_epoll <= 0 )
+      return f_stc_read(p_buffer, i_buflen, ps_tcp->socket, i_timeout);
+   if( i_buflen < 0 ) return STC__NGBUFSIZE;
+
+   buflen_tmp   = i_buflen;
+   p_buffer_tmp = (INTS1*) p_buffer;
+   i_wait       = (i_timeout >= 0) ? i_timeout*1000 : -1;
+
+   while( buflen_tmp > 0 )
+   {
+      retval = recv(ps_tcp->socket, p_buffer_tmp, buflen_tmp, 0);
+      if( retval > 0 )
+      {
+         buflen_tmp   -= retval;
+         p_buffer_tmp += retval;
+         if( i_timeout >= 0 ) i_wait = 100000; /* rest of buffer, as f_stc_read */
+         continue;
+      }
+      if( retval == 0 ) return STC__ECONNRES;
+      switch( errno )
+      {
+         case EINTR      : continue;
+         case EAGAIN     : break;
+         case EBADF      : return STC__INVSOCK;
+         case EFAULT     : return STC__INVBUF;
+         case ECONNRESET : return STC__ECONNRES;
+         default         : sprintf(c_msg,"STC recv error channel %d",ps_tcp->socket);
+                           perror(c_msg);
+                           return STC__FAILURE;
+      }
+      /* drained: edge triggered, only data arriving from now on wakes up */
+      if( ps_tcp->i_quickack == 1 ) f_stc_quickack(ps_tcp->socket);
+      retval = epoll_wait(ps_tcp->i_epoll, &s_event, 1, i_wait);
+      if( retval == 0 ) return STC__TIMEOUT;
+      if( retval == -1 && errno != EINTR )
+      {
+         sprintf(c_msg,"STC epoll error channel %d",ps_tcp->socket);
+         perror(c_msg);
+         return STC__FAILURE;
+      }
+   }
+   return STC__SUCCESS;
+#else
+   return f_stc_read(p_buffer, i_buflen, ps_tcp->socket, i_timeout);
+#endif
+} /* f_stc_recv()  */
+
+/* %%+HEAD: */
+/*****************+***********+****************************************/
+/*                                                                    */
+/*1+ PLI Main ****************+****************************************/
+/*                                                                    */
+/*+ Module      : f_stc_getopt                                        */
+/*                                                                    */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_stc_getopt( INTS4 i_channel ,                     */
+/*                              struct s_stcopt ps_opt )              */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : f_stc_getopt. socket options in effect.             */
+/*                                                                    */
+/*+ ARGUMENTS   :                                                     */
+/*                                                                    */
+/*+ i_channel   : Id from the connected socket.                       */
+/*+ ps_opt      : Pointer to structure s_stcopt, filled with the      */
+/*                values of the socket. l_rcvbuf is what the kernel   */
+/*                reserves, on Linux twice the value set.             */
+/*                l_keepalive is the idle time, 0 if keepalive is     */
+/*                off. l_timeout is always 0.                         */
+/*                                                                    */
+/*+ REMARKS     : Linux only, elsewhere STC__FAILURE is returned.     */
+/*                                                                    */
+/*2+IMPLEMENTATION************+****************************************/
+/*                                                                    */
+/*+ Return type : INTEGER                                             */
+/*+ Status codes:                                                     */
+/*-        STC__SUCCESS : success.                             */
+/*-        STC__FAILURE : failure.                             */
+/*                                                                    */
+/*1- PLI Main ****************+****************************************/
+/* %%-HEAD: */
+
+INTS4 f_stc_getopt(INTS4 i_channel, struct s_stcopt *ps_opt)
+{
+#ifdef GSI__LINUX
+   INTS4     l_val;
+   socklen_t l_len;
+
+   memset(ps_opt, 0, sizeof(struct s_stcopt));
+
+   l_len = sizeof(INTS4);
+   if( getsockopt(i_channel, SOL_SOCKET, SO_RCVBUF, &ps_opt->l_rcvbuf, &l_len) == -1 )
+      return STC__FAILURE;
+   l_len = sizeof(INTS4);
+   getsockopt(i_channel, IPPROTO_TCP, TCP_NODELAY, &ps_opt->l_nodelay, &l_len);
+#ifdef SO_BUSY_POLL
+   l_len = sizeof(INTS4);
+   getsockopt(i_channel, SOL_SOCKET, SO_BUSY_POLL, &ps_opt->l_busy_poll, &l_len);
+#endif
+#ifdef TCP_QUICKACK
+   l_len = sizeof(INTS4);
+   getsockopt(i_channel, IPPROTO_TCP, TCP_QUICKACK, &ps_opt->l_quickack, &l_len);
+#endif
+   l_val = 0;
+   l_len = sizeof(INTS4);
+   getsockopt(i_channel, SOL_SOCKET, SO_KEEPALIVE, &l_val, &l_len);
+   if( l_val != 0 )
+   {
+      l_len = sizeof(INTS4);
+      getsockopt(i_channel, IPPROTO_TCP, TCP_KEEPIDLE, &ps_opt->l_keepalive, &l_len);
+   }
+   return STC__SUCCESS;
+#else
+   return STC__FAILURE;
+#endif
+} /* f_stc_getopt()  */
+
+
 /* %%+HEAD: */
 /*****************+***********+****************************************/
 /*                                                                    */
@@ -468,6 +860,53 @@ INTS4 f_stc_write(void *p_buffer, INTS4 i_buflen, INTS4 i_channel)
 /* %%-HEAD: */
 
 INTS4 f_stc_connectserver(const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel, struct s_tcpcomm *ps_client)
+{
+   return f_stc_connectopt(c_node, l_port, pi_channel, ps_client, NULL);
+} /* f_stc_connectserver()  */
+
+/* %%+HEAD: */
+/*****************+***********+****************************************/
+/*                                                                    */
+/*1+ PLI Main ****************+****************************************/
+/*                                                                    */
+/*+ Module      : f_stc_connectopt                                    */
+/*                                                                    */
+/*--------------------------------------------------------------------*/
+/*+ CALLING     : f_stc_connectopt( CHARS c_node , INTS4 l_port ,     */
+/*                                  INTS4 pi_channel ,                */
+/*                                  struct s_tcpcomm ps_client ,      */
+/*                                  struct s_stcopt ps_opt )          */
+/*--------------------------------------------------------------------*/
+/*                                                                    */
+/*+ PURPOSE     : f_stc_connectopt. as f_stc_connectserver, with      */
+/*                                  socket options.                   */
+/*                                                                    */
+/*+ ARGUMENTS   :                                                     */
+/*                                                                    */
+/*+ ps_opt      : Pointer to structure s_stcopt, NULL: none. Fields   */
+/*                that are 0 keep the kernel default.                 */
+/*                                                                    */
+/*+ FUNCTION    : The options are set before the connect, so the TCP  */
+/*                window can grow to the receive buffer l_rcvbuf.     */
+/*                With l_timeout the connect fails with STC__CONNTOUT */
+/*                after l_timeout seconds. With l_keepalive the       */
+/*                kernel probes a silent connection every l_keepalive */
+/*                seconds. The kernel leaves quick ack mode after a   */
+/*                while, f_stc_recv sets l_quickack again.            */
+/*                See f_stc_getopt for the values in effect.          */
+/*                                                                    */
+/*+ REMARKS     : Linux only, elsewhere ps_opt is ignored.            */
+/*                                                                    */
+/*2+IMPLEMENTATION************+****************************************/
+/*                                                                    */
+/*+ Return type : INTEGER                                             */
+/*+ Status codes: as f_stc_connectserver.                             */
+/*                                                                    */
+/*1- PLI Main ****************+****************************************/
+/* %%-HEAD: */
+
+INTS4 f_stc_connectopt(const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel, struct s_tcpcomm *ps_client,
+                       const struct s_stcopt *ps_opt)
 {
    INTS4 retval;
    struct s_tcpcomm s_client;
@@ -502,6 +941,8 @@ INTS4 f_stc_connectserver(const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel,
 #endif
 
    s_client.socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+   s_client.i_epoll = 0;
+   s_client.i_quickack = 0;
 
    *ps_client = s_client;
    *pi_channel = s_client.socket; /* save channel also in case of error */
@@ -541,6 +982,13 @@ INTS4 f_stc_connectserver(const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel,
    s_client.sock.sin_addr   =
          * ((struct in_addr *) s_client.hostentstruct.h_addr);
 
+#ifdef GSI__LINUX
+   /* before connect: the receive buffer limits the window scale of the connection */
+   if( ps_opt != NULL ) f_stc_setopt(&s_client, ps_opt);
+   if( ps_opt != NULL && ps_opt->l_timeout > 0 )
+      retval = f_stc_connect_wait(&s_client, ps_opt->l_timeout);
+   else
+#endif
    retval = connect( s_client.socket,
          ( struct sockaddr *) &s_client.sock,
          sizeof(s_client.sock));
@@ -565,11 +1013,14 @@ INTS4 f_stc_connectserver(const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel,
    }  /* switch( errno )  */
    }
 
+#ifdef GSI__LINUX
+   if( s_client.i_quickack == 1 ) f_stc_quickack(s_client.socket);
+#endif
    *ps_client = s_client;
 
    return STC__SUCCESS;
 
-} /* f_stc_connectserver()  */
+} /* f_stc_connectopt()  */
 
 /* %%+HEAD: */
 /*****************+***********+****************************************/
@@ -855,6 +1306,8 @@ INTS4 f_stc_createserver(INTS4 *pl_port, struct s_tcpcomm *ps_server)
       retry = 0;
 
    s_server.sock_rw = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
+   s_server.i_epoll = 0;
+   s_server.i_quickack = 0;
 
    switch( s_server.sock_rw )
    {
@@ -1062,6 +1515,13 @@ INTS4 f_stc_close(struct s_tcpcomm * ps_tcp)
 {
    INTS4 retval;
 
+#ifdef GSI__LINUX
+   if( ps_tcp->i_epoll > 0 )
+   {
+      close(ps_tcp->i_epoll);
+      ps_tcp->i_epoll = 0;
+   }
+#endif
    if( ps_tcp->socket )
    {
       retval = shutdown( ps_tcp->socket,2);
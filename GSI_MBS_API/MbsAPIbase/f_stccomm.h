@@ -163,6 +163,10 @@ struct timeval {
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <netinet/tcp.h>
 #endif
 
 #ifdef GSI__SOLARIS
@@ -308,6 +312,18 @@ struct s_tcpcomm {
         struct hostent     hostentstruct;
         struct hostent     *hostentptr;
         INTS1              hostname[256] ;
+        INTS4              i_epoll;   /* epoll instance of socket, 0: none, see f_stc_epoll */
+        INTS4              i_quickack; /* 1: TCP_QUICKACK set again by f_stc_recv, see f_stc_connectopt */
+        } ;
+
+/* socket options of f_stc_connectopt, 0: kernel default */
+struct s_stcopt {
+        INTS4              l_rcvbuf;     /* SO_RCVBUF [bytes]                        */
+        INTS4              l_nodelay;    /* 1: TCP_NODELAY, -1: off                  */
+        INTS4              l_busy_poll;  /* SO_BUSY_POLL [microseconds]              */
+        INTS4              l_quickack;   /* 1: TCP_QUICKACK                          */
+        INTS4              l_keepalive;  /* SO_KEEPALIVE, probes after [seconds] idle */
+        INTS4              l_timeout;    /* connect timeout [seconds]                */
         } ;
 
 #ifdef vms
@@ -395,12 +411,17 @@ struct s_comm_portserv {
 
 #ifndef OSK
 INTS4 f_stc_connectserver (const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel, struct s_tcpcomm *ps_client);
+INTS4 f_stc_connectopt    (const CHARS *c_node, INTS4 l_port, INTS4 *pi_channel, struct s_tcpcomm *ps_client,
+                           const struct s_stcopt *ps_opt);
+INTS4 f_stc_getopt        (INTS4 i_channel, struct s_stcopt *ps_opt);
 INTS4 f_stc_createserver  (INTS4 *pl_port, struct s_tcpcomm *ps_server);
 INTS4 f_stc_listenserver  (struct s_tcpcomm *ps_server);
 INTS4 f_stc_acceptclient  (struct s_tcpcomm *ps_server, INTS4 *pi_channel);
 INTS4 f_stc_disperror     (INTS4 i_error, CHARS *c_dest, INTS4 i_out);
 INTS4 f_stc_read          (void *p_buffer, INTS4 i_buflen, INTS4 i_channel , INTS4 i_timeout);
 INTS4 f_stc_write         (void *p_buffer, INTS4 i_buflen, INTS4 i_channel);
+INTS4 f_stc_epoll         (struct s_tcpcomm *ps_tcp);
+INTS4 f_stc_recv          (struct s_tcpcomm *ps_tcp, void *p_buffer, INTS4 i_buflen, INTS4 i_timeout);
 INTS4 f_stc_close         (struct s_tcpcomm *ps_tcp);
 INTS4 f_stc_discclient    (INTS4 i_channel);
 
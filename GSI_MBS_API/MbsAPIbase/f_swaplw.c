@@ -36,7 +36,7 @@
 /*+ FUNCTION    : Long word byte swap. Works on the source field if   */
 /*                pp_dest points to value 0 or swaps from the source  */
 /*                to the destination field.                           */
-/*                (Should be replaced by a fast assembler routine)    */
+/*                Uses the vectorized kernels of f_ut_swap4.          */
 /*                                                                    */
 /*+ Return type : int (see s_errnum_def.h)                            */
 /*+ Status codes: bit 0: success                                      */
@@ -61,6 +61,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include "f_ut_swap4.h"
 
 /* function prototypes */
 
@@ -69,44 +70,8 @@
 int f_swaplw(int *pp_source, int l_len, int *pp_dest)
 
 {
-   unsigned char     *p_source, *p_dest, *p_s, *p_d;
-   unsigned int      lu_save;
-
    /* +++ action +++ */
-   p_source = (unsigned char *) pp_source;
-   p_dest   = (unsigned char *) pp_dest;
-
-   if (p_dest == NULL)
-   {
-        /* source == destination          */
-         for (p_d = (unsigned char *) p_source,
-              p_s = (unsigned char *) &lu_save;
-              p_d < p_source + (l_len * 4);
-              )
-         {
-             lu_save = *( (int *) p_d);
-             p_s    += 4;                 /* increment source               */
-             *(p_d++) = *(--p_s);
-             *(p_d++) = *(--p_s);
-             *(p_d++) = *(--p_s);
-             *(p_d++) = *(--p_s);
-         }
-   }
-   else
-   {
-         for (p_s = (unsigned char *) p_source,
-              p_d = (unsigned char *) p_dest;
-              p_s < p_source + (l_len * 4);
-              p_s += 4)
-         {
-             p_s     += 4;                /* increment source               */
-             *(p_d++) = *(--p_s);
-             *(p_d++) = *(--p_s);
-             *(p_d++) = *(--p_s);
-             *(p_d++) = *(--p_s);
-         }
-
-   }  /* dest == 0 */
+   if (l_len > 0) f_ut_swap4(pp_source, (size_t) l_len, pp_dest);
 
    return(0);
 }
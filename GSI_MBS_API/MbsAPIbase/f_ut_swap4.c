@@ -0,0 +1,160 @@
+// $Id$
+//-----------------------------------------------------------------------
+//       The GSI Online Offline Object Oriented (Go4) Project
+//         Experiment Data Processing at EE department, GSI
+//-----------------------------------------------------------------------
+// Copyright (C) 2000- GSI Helmholtzzentrum fr Schwerionenforschung GmbH
+//                     Planckstr. 1, 64291 Darmstadt, Germany
+// Contact:            http://go4.gsi.de
+//-----------------------------------------------------------------------
+// This software can be used under the license agreements as stated
+// in Go4License.txt file which is part of the distribution.
+//-----------------------------------------------------------------------
+
+#include "f_ut_swap4.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SWAP4__X86
+#include <immintrin.h>
+#endif
+
+static INTU4 f_swap4_word(INTU4 l)
+{
+#ifdef __GNUC__
+   return __builtin_bswap32(l);
+#else
+   return (l >> 24) | ((l >> 8) & 0x0000ff00) | ((l << 8) & 0x00ff0000) | (l << 24);
+#endif
+}
+
+static void f_swap4_scalar(const CHARS *pc_src, CHARS *pc_dst, size_t l_words)
+{
+   size_t i;
+   INTU4 l;
+
+   /* memcpy, because the buffers need no alignment */
+   for(i=0; i<l_words; i++)
+   {
+      memcpy(&l,pc_src+4*i,4);
+      l=f_swap4_word(l);
+      memcpy(pc_dst+4*i,&l,4);
+   }
+}
+
+#ifdef SWAP4__X86
+/* pshufb reverses the bytes of each word, the AVX variants shuffle within 128 bit lanes */
+#define SWAP4__MASK _mm_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3)
+
+__attribute__((target("ssse3")))
+static void f_swap4_ssse3(const CHARS *pc_src, CHARS *pc_dst, size_t l_words)
+{
+   const __m128i s_mask=SWAP4__MASK;
+   size_t i=0;
+
+   for(; i+4<=l_words; i+=4)
+   {
+      __m128i s_v=_mm_loadu_si128((const __m128i *)(pc_src+4*i));
+      _mm_storeu_si128((__m128i *)(pc_dst+4*i),_mm_shuffle_epi8(s_v,s_mask));
+   }
+   f_swap4_scalar(pc_src+4*i,pc_dst+4*i,l_words-i);
+}
+
+__attribute__((target("avx2")))
+static void f_swap4_avx2(const CHARS *pc_src, CHARS *pc_dst, size_t l_words)
+{
+   const __m256i s_mask=_mm256_broadcastsi128_si256(SWAP4__MASK);
+   size_t i=0;
+
+   for(; i+16<=l_words; i+=16)
+   {
+      __m256i s_v0=_mm256_loadu_si256((const __m256i *)(pc_src+4*i));
+      __m256i s_v1=_mm256_loadu_si256((const __m256i *)(pc_src+4*i+32));
+      _mm256_storeu_si256((__m256i *)(pc_dst+4*i),_mm256_shuffle_epi8(s_v0,s_mask));
+      _mm256_storeu_si256((__m256i *)(pc_dst+4*i+32),_mm256_shuffle_epi8(s_v1,s_mask));
+   }
+   f_swap4_scalar(pc_src+4*i,pc_dst+4*i,l_words-i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void f_swap4_avx512(const CHARS *pc_src, CHARS *pc_dst, size_t l_words)
+{
+   const __m512i s_mask=_mm512_broadcast_i32x4(SWAP4__MASK);
+   size_t i=0;
+
+   for(; i+32<=l_words; i+=32)
+   {
+      __m512i s_v0=_mm512_loadu_si512((const void *)(pc_src+4*i));
+      __m512i s_v1=_mm512_loadu_si512((const void *)(pc_src+4*i+64));
+      _mm512_storeu_si512((void *)(pc_dst+4*i),_mm512_shuffle_epi8(s_v0,s_mask));
+      _mm512_storeu_si512((void *)(pc_dst+4*i+64),_mm512_shuffle_epi8(s_v1,s_mask));
+   }
+   /* the rest with masked loads and stores */
+   for(; i<l_words; i+=16)
+   {
+      __mmask16 l_mask=(l_words-i >= 16) ? (__mmask16)0xffff : (__mmask16)((1u << (l_words-i))-1);
+      __m512i s_v=_mm512_maskz_loadu_epi32(l_mask,(const void *)(pc_src+4*i));
+      _mm512_mask_storeu_epi32((void *)(pc_dst+4*i),l_mask,_mm512_shuffle_epi8(s_v,s_mask));
+   }
+}
+#endif
+
+typedef struct
+{
+   const CHARS    *pc_name;
+   f_ut_swap4_fn   pf_kernel;
+   INTS4           l_supported;
+} s_swap4_kernel;
+
+static s_swap4_kernel s_kernels[]=
+{
+   {"scalar", f_swap4_scalar, 1},
+#ifdef SWAP4__X86
+   {"ssse3",  f_swap4_ssse3,  0},
+   {"avx2",   f_swap4_avx2,   0},
+   {"avx512", f_swap4_avx512, 0},
+#endif
+};
+#define SWAP4__KERNELS ((INTS4)(sizeof(s_kernels)/sizeof(s_kernels[0])))
+
+static s_swap4_kernel *ps_selected=&s_kernels[0];
+
+#ifdef SWAP4__X86
+/* runs once when the library is loaded, so the swap itself never checks the CPU */
+__attribute__((constructor))
+static void f_swap4_select(void)
+{
+   INTS4 i;
+
+   __builtin_cpu_init();
+   s_kernels[1].l_supported=__builtin_cpu_supports("ssse3") ? 1 : 0;
+   s_kernels[2].l_supported=__builtin_cpu_supports("avx2") ? 1 : 0;
+   s_kernels[3].l_supported=(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) ? 1 : 0;
+   for(i=0; i<SWAP4__KERNELS; i++)
+      if(s_kernels[i].l_supported) ps_selected=&s_kernels[i];
+}
+#endif
+
+void f_ut_swap4(void *p_source, size_t l_words, void *p_dest)
+{
+   if(p_dest == NULL) p_dest=p_source;
+   ps_selected->pf_kernel((const CHARS *)p_source,(CHARS *)p_dest,l_words);
+}
+
+const CHARS *f_ut_swap4_kernel(void)
+{
+   return ps_selected->pc_name;
+}
+
+INTS4 f_ut_swap4_kernels(void)
+{
+   return SWAP4__KERNELS;
+}
+
+f_ut_swap4_fn f_ut_swap4_kernel_at(INTS4 l_kernel, const CHARS **ppc_name)
+{
+   if((l_kernel < 0)||(l_kernel >= SWAP4__KERNELS)) return NULL;
+   if(ppc_name != NULL) *ppc_name=s_kernels[l_kernel].pc_name;
+   return s_kernels[l_kernel].l_supported ? s_kernels[l_kernel].pf_kernel : NULL;
+}
@@ -0,0 +1,31 @@
+// $Id$
+//-----------------------------------------------------------------------
+//       The GSI Online Offline Object Oriented (Go4) Project
+//         Experiment Data Processing at EE department, GSI
+//-----------------------------------------------------------------------
+// Copyright (C) 2000- GSI Helmholtzzentrum fr Schwerionenforschung GmbH
+//                     Planckstr. 1, 64291 Darmstadt, Germany
+// Contact:            http://go4.gsi.de
+//-----------------------------------------------------------------------
+// This software can be used under the license agreements as stated
+// in Go4License.txt file which is part of the distribution.
+//-----------------------------------------------------------------------
+
+#ifndef F_UT_SWAP4_H
+#define F_UT_SWAP4_H
+
+#include <stddef.h>
+#include "typedefs.h"
+
+/* byte swap of 32 bit words, in place if p_dest is NULL. The kernel (scalar, SSSE3, AVX2, AVX-512)
+   is selected once from the CPU features. Source and destination need no alignment. */
+void  f_ut_swap4(void *p_source, size_t l_words, void *p_dest);
+const CHARS *f_ut_swap4_kernel(void);
+
+/* the compiled kernels, for m_ut_swap4_bench. f_ut_swap4_kernel_at returns NULL
+   for a kernel the CPU does not support. */
+typedef void (*f_ut_swap4_fn)(const CHARS *pc_src, CHARS *pc_dst, size_t l_words);
+INTS4 f_ut_swap4_kernels(void);
+f_ut_swap4_fn f_ut_swap4_kernel_at(INTS4 l_kernel, const CHARS **ppc_name);
+
+#endif
@@ -0,0 +1,82 @@
+// $Id$
+//-----------------------------------------------------------------------
+//       The GSI Online Offline Object Oriented (Go4) Project
+//         Experiment Data Processing at EE department, GSI
+//-----------------------------------------------------------------------
+// Copyright (C) 2000- GSI Helmholtzzentrum fr Schwerionenforschung GmbH
+//                     Planckstr. 1, 64291 Darmstadt, Germany
+// Contact:            http://go4.gsi.de
+//-----------------------------------------------------------------------
+// This software can be used under the license agreements as stated
+// in Go4License.txt file which is part of the distribution.
+//-----------------------------------------------------------------------
+
+
+/* measures the throughput of every f_ut_swap4 kernel the CPU supports:
+   m_ut_swap4_bench [bytes] [loops] */
+#include "typedefs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "f_ut_swap4.h"
+
+int main(int argc, char *argv[])
+{
+   size_t l_bytes=16*1024*1024, l_words, i;
+   INTS4 l_loops=100, k, l;
+   INTU4 *pl_src, *pl_ref, *pl_dst;
+   const CHARS *pc_name;
+   f_ut_swap4_fn pf_kernel;
+   clock_t l_start;
+   double d_sec;
+
+   if(argc > 1) l_bytes=(size_t)strtoul(argv[1],NULL,0);
+   if(argc > 2) l_loops=atol(argv[2]);
+   l_words=l_bytes/4;
+   if((l_words == 0)||(l_loops <= 0))
+   {
+      printf("m_ut_swap4_bench [bytes] [loops]\n");
+      return 1;
+   }
+   pl_src=(INTU4 *)malloc(l_words*4);
+   pl_ref=(INTU4 *)malloc(l_words*4);
+   pl_dst=(INTU4 *)malloc(l_words*4);
+   if((pl_src == NULL)||(pl_ref == NULL)||(pl_dst == NULL))
+   {
+      printf("m_ut_swap4_bench: no memory for %lu bytes\n",(unsigned long)l_bytes);
+      free(pl_src); free(pl_ref); free(pl_dst);
+      return 1;
+   }
+   for(i=0; i<l_words; i++)
+   {
+      pl_src[i]=(INTU4)(i*2654435761u);
+      pl_ref[i]=(pl_src[i] >> 24) | ((pl_src[i] >> 8) & 0x0000ff00) |
+                ((pl_src[i] << 8) & 0x00ff0000) | (pl_src[i] << 24);
+   }
+
+   for(k=0; k<f_ut_swap4_kernels(); k++)
+   {
+      pf_kernel=f_ut_swap4_kernel_at(k,&pc_name);
+      if(pf_kernel == NULL)
+      {
+         printf("m_ut_swap4_bench: %-6s not supported\n",pc_name);
+         continue;
+      }
+      pf_kernel((const CHARS *)pl_src,(CHARS *)pl_dst,l_words);
+      if(memcmp(pl_dst,pl_ref,l_words*4) != 0)
+      {
+         printf("m_ut_swap4_bench: %-6s wrong result\n",pc_name);
+         continue;
+      }
+      l_start=clock();
+      for(l=0; l<l_loops; l++)
+         pf_kernel((const CHARS *)pl_dst,(CHARS *)pl_dst,l_words);
+      d_sec=(double)(clock()-l_start)/CLOCKS_PER_SEC;
+      printf("m_ut_swap4_bench: %-6s %8.2f GB/s%s\n",pc_name,
+             d_sec > 0 ? (double)l_words*4*l_loops/d_sec/1e9 : 0.,
+             strcmp(pc_name,f_ut_swap4_kernel()) == 0 ? " (selected)" : "");
+   }
+   free(pl_src); free(pl_ref); free(pl_dst);
+   return 0;
+}
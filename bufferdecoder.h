@@ -0,0 +1,280 @@
+/*
+    A C++ client for a GSI MBS stream server.
+    Can also asynchronously open a set of LMD (List Mode) files.
+
+    Copyright (C) 2014-2023 Maxim Singer
+
+    License: GNU GPLv3 (https://www.gnu.org/licenses/gpl-3.0.html)
+
+    Source code: https://github.com/virtmax/MbsClient
+*/
+
+
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+extern "C"
+{
+#include "s_bufhe_swap.h"
+#include "s_evhe_swap.h"
+#include "s_ve10_1_swap.h"
+}
+
+
+#pragma once
+
+
+/**
+ * @brief Splits blocks of MBS buffers, e.g. from f_evt_get_block(...), into events
+ *          in the same way as f_evt_get_event(...), including spanned events.
+ *
+ * Between two blocks the decoder keeps the spanned event that is not complete yet.
+ * decode(...) continues with this state. speculate(...) decodes a block without the previous blocks:
+ * it assumes the state the first buffer suggests and keeps the end of a spanned event from an earlier
+ * block apart. join(...) checks the assumption against the decoder with the real state and adds
+ * the end of the spanned event. If the assumption was wrong, e.g. for the first block of a file
+ * or after a missing buffer, the block must be decoded again with decode(...).
+ * The buffers must be in the byte order of this machine.
+ *
+ * The sink is called as sink(const s_ve10_1* event, const s_bufhe* header) with the header of the buffer
+ * the event starts in. The pointers are valid during the call only.
+ */
+class BufferDecoder
+{
+public:
+    explicit BufferDecoder(size_t bufferSize = 0) { reset(bufferSize); }
+
+    /**
+     * @brief Start over, e.g. with the next file.
+     * @param bufferSize The size of the MBS buffers in bytes (l_buf_size of the channel).
+     */
+    void reset(size_t bufferSize)
+    {
+        this->bufferSize = bufferSize;
+        state = State();
+        partial.clear();
+        speculative = false;
+        entry = Entry();
+        head.clear();
+        headComplete = false;
+        headDropped = false;
+        nBrokenBuffers = 0;
+    }
+
+    /**
+     * @brief Decode a block of whole buffers after the blocks decoded so far.
+     */
+    template<typename Sink>
+    void decode(const char* block, size_t bytes, Sink&& sink)
+    {
+        speculative = false;
+        walk(block, bytes, sink);
+    }
+
+    /**
+     * @brief Decode a block of whole buffers without the previous blocks. Call it on a decoder after reset(...).
+     */
+    template<typename Sink>
+    void speculate(const char* block, size_t bytes, Sink&& sink)
+    {
+        speculative = true;
+        walk(block, bytes, sink);
+    }
+
+    /**
+     * @brief Continue this decoder with a block decoded by speculate(...) on the other decoder.
+     *          Calls the sink for the spanned event completed at the begin of the block.
+     *          The events of the block itself follow after it.
+     * @return false, if the block depends on a state other than the assumed one. Nothing is changed then.
+     */
+    template<typename Sink>
+    bool join(BufferDecoder& block, Sink&& sink)
+    {
+        const Entry& e = block.entry;
+        if(!e.known || e.spanning != state.spanning
+           || (e.afterFirstBuffer && state.firstBuffer)
+           || (e.previousBuffer && state.bufferNumber != e.bufferNumber - 1))
+            return false;
+
+        if(e.spanning)
+        {
+            if(block.headDropped)
+                partial.clear();
+            else
+            {
+                partial.insert(partial.end(), block.head.begin(), block.head.end());
+                if(block.headComplete)
+                    completePartial(sink);
+            }
+        }
+
+        state = block.state;
+        if(!block.headOpen())
+        {
+            partial.swap(block.partial);
+            partialHeader = block.partialHeader;
+        }
+        nBrokenBuffers += block.nBrokenBuffers;
+        return true;
+    }
+
+    /**
+     * @brief Return the number of buffers with an event that exceeds the buffer. The rest of these buffers is dropped.
+     */
+    size_t brokenBuffers() const { return nBrokenBuffers; }
+
+private:
+    // the state of f_evt_get_event(...) between two buffers
+    struct State
+    {
+        bool spanning = false;      // a spanned event is not complete (l_evt_buf_posi != 0)
+        bool firstBuffer = true;    // no event seen since open (l_first_buf)
+        INTS4 bufferNumber = 0;     // number of the last buffer (l_buf_no)
+    };
+
+    // what a speculatively decoded block assumed about the state before it
+    struct Entry
+    {
+        bool known = false;             // the block has a buffer with events
+        bool spanning = false;
+        bool afterFirstBuffer = false;  // firstBuffer must be false
+        bool previousBuffer = false;    // the last buffer must be the one before the block
+        INTS4 bufferNumber = 0;         // number of the first buffer with events
+    };
+
+    // the spanned event from an earlier block is still continued by the block
+    bool headOpen() const { return speculative && entry.spanning && !headComplete && !headDropped; }
+
+    template<typename Sink>
+    void completePartial(Sink& sink)
+    {
+        // like f_evt_get_event(...), the length in the event header becomes the length of all fragments
+        s_ve10_1* event = reinterpret_cast<s_ve10_1*>(partial.data());
+        event->l_dlen = static_cast<INTS4>(partial.size()/2 - 4);
+        sink(static_cast<const s_ve10_1*>(event), static_cast<const s_bufhe*>(&partialHeader));
+        partial.clear();
+    }
+
+    template<typename Sink>
+    void walk(const char* block, size_t bytes, Sink& sink)
+    {
+        for(size_t bufferPos = 0; bufferSize > 0 && bufferPos + bufferSize <= bytes; bufferPos += bufferSize)
+        {
+            const s_bufhe* header = reinterpret_cast<const s_bufhe*>(block + bufferPos);
+            bool previousOk = state.bufferNumber == header->l_buf - 1;
+            state.bufferNumber = header->l_buf;
+            if(header->i_type == 2000)  // file header
+                continue;
+
+            // large buffers count the used words in l_free[2]
+            int64_t used = header->l_dlen <= MAX__DLEN ? header->i_used : header->l_free[2];
+            size_t pos = bufferPos + sizeof(s_bufhe);
+            const size_t limit = std::min(pos + static_cast<size_t>(std::max<int64_t>(used, 0))*2, bufferPos + bufferSize);
+
+            if(speculative && !entry.known && pos < limit)
+            {
+                // the first buffer with events tells what the state before the block should be
+                entry.known = true;
+                entry.spanning = header->h_end == 1;
+                entry.afterFirstBuffer = header->h_end == 1;
+                entry.previousBuffer = header->h_end == 1 && bufferPos == 0;
+                entry.bufferNumber = header->l_buf;
+                state.spanning = entry.spanning;
+                state.firstBuffer = false;
+                if(bufferPos == 0)
+                    previousOk = true;
+            }
+
+            while(pos < limit)
+            {
+                const bool fragment = state.spanning || (header->h_end == 1 && state.firstBuffer);
+                const s_ve10_1* element = reinterpret_cast<const s_ve10_1*>(block + pos);
+                int64_t length = 0;
+                bool broken = pos + sizeof(s_evhe) > limit;
+                if(!broken)
+                {
+                    if(fragment)
+                    {
+                        pos += sizeof(s_evhe);
+                        length = int64_t(element->l_dlen)*2;
+                    }
+                    else
+                        length = (int64_t(element->l_dlen) - 4)*2 + int64_t(sizeof(s_ve10_1));
+                    broken = length < 0 || (length == 0 && !fragment) || pos + length > limit;
+                }
+
+                if(broken)
+                {
+                    // f_evt_get_event(...) returns GETEVT__FRAGMENT here
+                    nBrokenBuffers++;
+                    dropPartial();
+                    break;
+                }
+
+                // a buffer that starts with the end of an event nobody has seen the begin of
+                if(header->h_end == 1 && (state.firstBuffer || !previousOk))
+                {
+                    state.firstBuffer = false;
+                    previousOk = true;
+                    dropPartial();
+                    pos += length;
+                    continue;
+                }
+
+                state.firstBuffer = false;
+
+                if(!state.spanning && (header->h_begin == 0 || pos + length < limit))
+                {
+                    sink(element, header);
+                    pos += length;
+                    continue;
+                }
+
+                // begin or continuation of a spanned event
+                if(!state.spanning)
+                {
+                    partialHeader = *header;
+                    partial.clear();
+                }
+                std::vector<char>& fragments = headOpen() ? head : partial;
+                fragments.insert(fragments.end(), block + pos, block + pos + length);
+                pos += length;
+                state.spanning = headOpen() || !partial.empty();
+
+                if(header->h_begin != 1 || pos < limit)
+                {
+                    state.spanning = false;
+                    if(headOpen())
+                        headComplete = true;
+                    else
+                        completePartial(sink);
+                }
+            }
+        }
+    }
+
+    void dropPartial()
+    {
+        if(headOpen())
+            headDropped = true;
+        partial.clear();
+        state.spanning = false;
+    }
+
+    size_t bufferSize = 0;
+    State state;
+    std::vector<char> partial;      // fragments of the spanned event, starting with its event header
+    s_bufhe partialHeader;          // header of the buffer the spanned event starts in
+
+    // only for speculate(...)
+    bool speculative = false;
+    Entry entry;
+    std::vector<char> head;         // fragments that end a spanned event from an earlier block
+    bool headComplete = false;
+    bool headDropped = false;
+
+    size_t nBrokenBuffers = 0;
+};
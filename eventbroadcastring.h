@@ -0,0 +1,131 @@
+/*
+    A C++ client for a GSI MBS stream server.
+    Can also asynchronously open a set of LMD (List Mode) files.
+
+    Copyright (C) 2014-2023 Maxim Singer
+
+    License: GNU GPLv3 (https://www.gnu.org/licenses/gpl-3.0.html)
+
+    Source code: https://github.com/virtmax/MbsClient
+*/
+
+
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+#pragma once
+
+
+/**
+ * @brief Bounded single-producer/multi-consumer ring, every consumer reads every element.
+ *
+ * The ring does not know the consumers. Each consumer keeps its own read position (sequence number).
+ * The producer overwrites the oldest slot when the ring is full, so the producer has to check the
+ * positions of the consumers that must not lose elements before publish(...).
+ * Each slot is protected by a tiny spinlock, a consumer detects an overwritten slot by its sequence number.
+ * The capacity is rounded up to the next power of two.
+ */
+template<typename T>
+class EventBroadcastRing
+{
+public:
+    explicit EventBroadcastRing(size_t capacity = 1024) { resize(capacity); }
+
+    EventBroadcastRing(const EventBroadcastRing&) = delete;
+    EventBroadcastRing& operator=(const EventBroadcastRing&) = delete;
+
+    /**
+     * @brief Reallocate the slots. Not thread safe, all stored elements are dropped.
+     * @param capacity Minimal number of slots.
+     */
+    void resize(size_t capacity)
+    {
+        size_t n = 1;
+        while(n < capacity)
+            n <<= 1;
+
+        slots.reset(new Slot[n]);
+        nSlots = n;
+        mask = n - 1;
+        writePosition.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return nSlots; }
+
+    /**
+     * @brief Sequence number of the next element to be published. All smaller ones are readable.
+     */
+    uint64_t published() const { return writePosition.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Producer side. Store the element with the next sequence number, overwrite the oldest one.
+     */
+    void publish(T&& item)
+    {
+        const uint64_t seq = writePosition.load(std::memory_order_relaxed);
+        Slot& slot = slots[seq & mask];
+
+        lock(slot);
+        slot.item = std::move(item);
+        slot.seq = seq;
+        unlock(slot);
+
+        writePosition.store(seq + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consumer side. Copy the element with the sequence number seq.
+     * @return false, if the element is not published yet or already overwritten.
+     */
+    bool read(uint64_t seq, T& item) const
+    {
+        return peek(seq, [&item](const T& element) { item = element; });
+    }
+
+    /**
+     * @brief Consumer side. Call reader(element) for the element with the sequence number seq without a copy.
+     *          The slot is locked while reader runs.
+     * @return false, if the element is not published yet or already overwritten.
+     */
+    template<typename Reader>
+    bool peek(uint64_t seq, Reader&& reader) const
+    {
+        if(seq >= published())
+            return false;
+
+        Slot& slot = slots[seq & mask];
+        lock(slot);
+        const bool valid = (slot.seq == seq);
+        if(valid)
+            reader(static_cast<const T&>(slot.item));
+        unlock(slot);
+        return valid;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic_flag busy = ATOMIC_FLAG_INIT;
+        uint64_t seq = UINT64_MAX;
+        T item;
+    };
+
+    static void lock(Slot& slot)
+    {
+        while(slot.busy.test_and_set(std::memory_order_acquire))
+            ;
+    }
+
+    static void unlock(Slot& slot) { slot.busy.clear(std::memory_order_release); }
+
+    std::unique_ptr<Slot[]> slots;
+    size_t nSlots = 0;
+    size_t mask = 0;
+
+    std::atomic<uint64_t> writePosition{0};
+};
@@ -0,0 +1,143 @@
+/*
+    A C++ client for a GSI MBS stream server.
+    Can also asynchronously open a set of LMD (List Mode) files.
+
+    Copyright (C) 2014-2023 Maxim Singer
+
+    License: GNU GPLv3 (https://www.gnu.org/licenses/gpl-3.0.html)
+
+    Source code: https://github.com/virtmax/MbsClient
+*/
+
+
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+
+#pragma once
+
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of event slots.
+ *
+ * The producer (the receiver thread) only writes the tail index, the consumer only writes the head index.
+ * Both indices live on their own cache lines together with a cached copy of the opposite index,
+ * so producer and consumer neither block nor false-share with each other.
+ * The capacity is rounded up to the next power of two.
+ */
+template<typename T>
+class EventRingBuffer
+{
+public:
+    explicit EventRingBuffer(size_t capacity = 1024) { resize(capacity); }
+
+    EventRingBuffer(const EventRingBuffer&) = delete;
+    EventRingBuffer& operator=(const EventRingBuffer&) = delete;
+
+    /**
+     * @brief Reallocate the slots. Not thread safe, all stored elements are dropped.
+     * @param capacity Minimal number of slots.
+     */
+    void resize(size_t capacity)
+    {
+        size_t n = 1;
+        while(n < capacity)
+            n <<= 1;
+
+        slots = std::vector<T>(n);
+        mask = n - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        cachedHead = 0;
+        cachedTail = 0;
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+    size_t size() const
+    {
+        // load head first, so that tail >= head holds for the two values
+        const size_t h = head.load(std::memory_order_acquire);
+        const size_t t = tail.load(std::memory_order_acquire);
+        return t - h;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Producer side. Move an element into the ring.
+     * @return false, if the ring is full. The element is not touched in this case.
+     */
+    bool push(T&& item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if(t - cachedHead == slots.size())
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if(t - cachedHead == slots.size())
+                return false;
+        }
+
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side. Move up to n elements to the output iterator.
+     * @return The number of moved elements.
+     */
+    template<typename OutputIt>
+    size_t pop(OutputIt out, size_t n)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if(cachedTail - h < n)
+            cachedTail = tail.load(std::memory_order_acquire);
+
+        n = std::min(n, cachedTail - h);
+        for(size_t i = 0; i < n; i++)
+        {
+            *out = std::move(slots[(h + i) & mask]);
+            ++out;
+        }
+
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Consumer side. Drop all stored elements.
+     * @return The number of dropped elements.
+     */
+    size_t clear()
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        cachedTail = tail.load(std::memory_order_acquire);
+
+        for(size_t i = h; i != cachedTail; i++)
+            slots[i & mask] = T();
+
+        head.store(cachedTail, std::memory_order_release);
+        return cachedTail - h;
+    }
+
+private:
+    static constexpr size_t cacheLineSize = 64;
+
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    // consumer owned
+    alignas(cacheLineSize) std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+
+    // producer owned
+    alignas(cacheLineSize) std::atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+
+    char padding[cacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
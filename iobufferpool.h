@@ -0,0 +1,97 @@
+/*
+    A C++ client for a GSI MBS stream server.
+    Can also asynchronously open a set of LMD (List Mode) files.
+
+    Copyright (C) 2014-2023 Maxim Singer
+
+    License: GNU GPLv3 (https://www.gnu.org/licenses/gpl-3.0.html)
+
+    Source code: https://github.com/virtmax/MbsClient
+*/
+
+
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+
+#pragma once
+
+
+/**
+ * @brief Pool of reference-counted I/O buffers.
+ *
+ * acquire(...) is called by the reading thread, the last owner of a buffer may be any thread.
+ * A released buffer goes back to the pool instead of the heap, as long as the pool exists
+ * and the buffer has the current block size.
+ */
+class IoBufferPool
+{
+public:
+    IoBufferPool() : state(std::make_shared<State>()) {}
+
+    IoBufferPool(const IoBufferPool&) = delete;
+    IoBufferPool& operator=(const IoBufferPool&) = delete;
+
+    /**
+     * @brief Get a buffer of at least nBytes.
+     * @return The buffer. It returns to the pool when the last copy of the pointer is released.
+     */
+    std::shared_ptr<char> acquire(size_t nBytes)
+    {
+        char* block = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(nBytes != state->blockSize)
+            {
+                // a new source with another buffer size, the old blocks are not needed anymore
+                for(char* b : state->freeBlocks)
+                    delete[] b;
+                state->freeBlocks.clear();
+                state->blockSize = nBytes;
+            }
+
+            if(!state->freeBlocks.empty())
+            {
+                block = state->freeBlocks.back();
+                state->freeBlocks.pop_back();
+            }
+        }
+
+        if(block == nullptr)
+            block = new char[nBytes];
+
+        std::weak_ptr<State> owner = state;
+        return std::shared_ptr<char>(block, [owner, nBytes](char* b)
+        {
+            if(auto s = owner.lock())
+            {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if(nBytes == s->blockSize)
+                {
+                    s->freeBlocks.push_back(b);
+                    return;
+                }
+            }
+            delete[] b;
+        });
+    }
+
+private:
+    struct State
+    {
+        ~State()
+        {
+            for(char* b : freeBlocks)
+                delete[] b;
+        }
+
+        std::mutex mutex;
+        size_t blockSize = 0;
+        std::vector<char*> freeBlocks;
+    };
+
+    std::shared_ptr<State> state;
+};
@@ -16,15 +16,23 @@
 
 #include "mbsclient.h"
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 MbsClient::MbsClient() : mbsSource("not connected")
 {
     disconnected = true;
     sizeOfReceivedData = 0;
-    nEventsInBuffer = 0;
     nReceivedEvents = 0;
     maxEventBufferSize = 1e6;
+    eventBuffer.resize(maxEventBufferSize);
+    broadcast = std::make_shared<Broadcast>();
 
     inputChannel = nullptr;
     fileHeader = nullptr;
@@ -40,15 +48,18 @@ MbsClient::~MbsClient()
 bool MbsClient::connect(std::string mbsSource, ConnectionOption conOpt, bool poolForNextFile)
 {
     sizeOfReceivedData = 0;
-    nEventsInBuffer = 0;
     nReceivedEvents = 0;
+    nMalformedEvents = 0;
     noMoreEvents = false;
+    bytesInBufferHighWaterMark = bytesInBuffer.load();
+    receiverStallTime = 0;
+    nReconnects = 0;
+    reconnectDowntime = 0;
+    resizeEventBuffer();
 
-    INTS4 sourceType = 0;
+    INTS4 sourceType = serverType(conOpt);
     if(conOpt == ConnectionOption::file)
         sourceType = GETEVT__FILE;
-    else if(conOpt== ConnectionOption::stream)
-        sourceType = GETEVT__STREAM;
     else if(conOpt== ConnectionOption::automatic)
     {
         if(mbsSource.size() < 5)
@@ -65,26 +76,37 @@ bool MbsClient::connect(std::string mbsSource, ConnectionOption conOpt, bool poo
         else
             sourceType = GETEVT__STREAM;
     }
-    else
+    else if(sourceType == 0)
     {
-        std::cout << "MbsClient::connect: CONNECTION_OPTION must be file or stream." << std::endl;
+        std::cout << "MbsClient::connect: CONNECTION_OPTION must be file, automatic or a server." << std::endl;
+        return false;
     }
 
     if(sourceType != GETEVT__FILE)
     {
         std::cout << "MbsClient::connect: option for seeking for a next file is not possible"
-                  << "for stream connections. ignore." << std::endl;
+                  << "for server connections. ignore." << std::endl;
         poolForNextFile = false;
     }
 
-    filelist.push_back(mbsSource);
+    {
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        filelist = {mbsSource};
+        currentFileIndex = 0;
+        seekingFiles = poolForNextFile;
+    }
 
+    followFile = followFiles && sourceType == GETEVT__FILE;
+    if(followFile)
+        watchFile(mbsSource);
 
-    if(openLmdFile(filelist.at(0), sourceType))
+    if(openLmdFile(mbsSource, sourceType))
     {
         if(poolForNextFile)
             fileseekThread.push_back(std::thread(&MbsClient::newFileSeeker, this));
 
+        startBatchWorkers();
+        startDecodeWorkers();
         receiverThread.push_back(std::thread(&MbsClient::eventReceiver, this));
         return true;
     }
@@ -97,18 +119,34 @@ bool MbsClient::connect(std::vector<std::string> fileList, bool poolForNextFile)
     if(fileList.size() == 0)
         return false;
 
-    this->filelist = fileList;
+    {
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        this->filelist = fileList;
+        currentFileIndex = 0;
+        seekingFiles = poolForNextFile;
+    }
+
+    followFile = followFiles;
+    if(followFile)
+        watchFile(fileList.at(0));
 
     sizeOfReceivedData = 0;
-    nEventsInBuffer = 0;
     nReceivedEvents = 0;
+    nMalformedEvents = 0;
     noMoreEvents = false;
+    bytesInBufferHighWaterMark = bytesInBuffer.load();
+    receiverStallTime = 0;
+    nReconnects = 0;
+    reconnectDowntime = 0;
+    resizeEventBuffer();
 
     if(openLmdFile(fileList.at(0), GETEVT__FILE))
     {
         if(poolForNextFile)
             fileseekThread.push_back(std::thread(&MbsClient::newFileSeeker, this));
 
+        startBatchWorkers();
+        startDecodeWorkers();
         receiverThread.push_back(std::thread(&MbsClient::eventReceiver, this));
         return true;
     }
@@ -116,15 +154,86 @@ bool MbsClient::connect(std::vector<std::string> fileList, bool poolForNextFile)
         return false;
 }
 
+bool MbsClient::connect(const std::vector<std::string> &servers, ConnectionOption conOpt, MergeOrder order,
+                        size_t reorderWindow)
+{
+    if(servers.size() == 0)
+        return false;
+
+    const INTS4 sourceType = conOpt == ConnectionOption::automatic ? GETEVT__STREAM : serverType(conOpt);
+    if(sourceType == 0)
+    {
+        std::cout << "MbsClient::connect: only servers can be read at the same time. Use connect(fileList, ...) for files."
+                  << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        filelist = servers;
+        currentFileIndex = 0;
+        seekingFiles = false;
+    }
+    followFile = false;
+
+    sizeOfReceivedData = 0;
+    nReceivedEvents = 0;
+    nMalformedEvents = 0;
+    noMoreEvents = false;
+    bytesInBufferHighWaterMark = bytesInBuffer.load();
+    receiverStallTime = 0;
+    nReconnects = 0;
+    reconnectDowntime = 0;
+    resizeEventBuffer();
+
+    mergeOrder = order;
+    mergeWindow = std::max<size_t>(reorderWindow, 1);
+
+    std::string names;
+    for(size_t i = 0; i < servers.size(); i++)
+    {
+        std::unique_ptr<MergeSource> source(new MergeSource());
+        source->name = servers[i];
+        source->index = static_cast<int16_t>(i);
+        source->type = sourceType;
+        source->channel = openServer(servers[i], sourceType);
+        if(source->channel == nullptr)
+        {
+            std::cout << "MbsClient::connect: Can't open '" << servers[i]
+                      << "': result != GETEVT__SUCCESS. Is the IP address correct?" << std::endl;
+            stopMergeSources();
+            return false;
+        }
+
+        source->socket = source->channel->l_channel_no;
+        names += (i > 0 ? "," : "") + servers[i];
+        mergeSources.push_back(std::move(source));
+    }
+    std::cout << "MbsClient::connect: Connection successful." << std::endl;
+
+    mbsSource = names;
+    disconnected = false;
+
+    for(auto& source : mergeSources)
+        source->thread = std::thread(&MbsClient::sourceReceiver, this, std::ref(*source));
+
+    startBatchWorkers();
+    receiverThread.push_back(std::thread(&MbsClient::mergeReceiver, this));
+    return true;
+}
+
 
 bool MbsClient::openLmdFile(std::string mbsSource, INTS4 sourceType)
 {
+    // the channel of the previous file is closed already. it holds the file header
+    free(inputChannel);
     inputChannel = nullptr;
     fileHeader = nullptr;
     bufferHeader = nullptr;
 
     // initialize the input channel
     inputChannel = f_evt_control();
+    configureChannel(inputChannel, sourceType);
 
     /*+   first argument of f_evt_get_open()    : Type of server:         */
     /*-               GETEVT__FILE   : Input from file                    */
@@ -133,8 +242,9 @@ bool MbsClient::openLmdFile(std::string mbsSource, INTS4 sourceType)
     /*-               GETEVT__EVENT  : Input from MBS event server        */
     /*-               GETEVT__REVSERV: Input from remote event server     */
     //   second argument of f_evt_get_open()    : name of server
+    //   fifth argument of f_evt_get_open()     : sample rate of an event server
     int32_t result = f_evt_get_open(sourceType, mbsSource.c_str(), inputChannel,
-                                    (CHARS**) (&fileHeader), 1, 0);
+                                    (CHARS**) (&fileHeader), static_cast<INTS4>(eventSampleRate.load()), 0);
 
     if(result != GETEVT__SUCCESS)
     {
@@ -145,9 +255,21 @@ bool MbsClient::openLmdFile(std::string mbsSource, INTS4 sourceType)
     else
     {
         std::cout << "MbsClient::connect: Connection successful." << std::endl;
+        if(sourceType != GETEVT__FILE)
+            logSocketOptions(inputChannel, mbsSource);
     }
 
     this->mbsSource = mbsSource;
+    inputType = sourceType;
+    if(sourceType != GETEVT__FILE)
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        serverSocket = inputChannel->l_channel_no;
+    }
+
+    // files in the buffer format can be split into events by several threads
+    decodeBlocks = nDecodeThreads > 0 && sourceType == GETEVT__FILE && inputChannel->pLmd == nullptr;
+    blockDecoder.reset(inputChannel->l_buf_size);
 
     if (fileHeader != nullptr)
     {
@@ -161,82 +283,442 @@ bool MbsClient::openLmdFile(std::string mbsSource, INTS4 sourceType)
     return true;
 }
 
-void MbsClient::newFileSeeker()
+void MbsClient::configureChannel(s_evt_channel *channel, INTS4 sourceType)
 {
-    while(!disconnected)
+    // by default files are read through a memory mapping, the receiver copies each event into its record anyway
+    const FileReadMode readMode = fileReadMode;
+    f_evt_file_follow(channel, followFile && sourceType == GETEVT__FILE ? 1 : 0);
+    f_evt_stream_depth(channel, static_cast<INTS4>(streamRequestDepth.load()));
+    f_evt_file_mmap(channel, readMode == FileReadMode::mapped ? 1 : 0);
+    f_evt_file_uring(channel, readMode == FileReadMode::ioUring ? 1 : 0);
+    f_evt_file_block(channel, static_cast<INTS4>(fileBlockSize.load()), static_cast<INTS4>(fileReadAheadBlocks.load()));
+    // data in the other byte order is swapped while it is copied into the records
+    f_evt_lazy_swap(channel, 1);
+
+    if(sourceType != GETEVT__FILE)
+    {
+        std::lock_guard<std::mutex> lock(socketOptionsMutex);
+        s_stcopt options = {};
+        options.l_rcvbuf = static_cast<INTS4>(std::min(socketOptions.receiveBuffer, size_t(INT32_MAX)));
+        options.l_nodelay = !socketOptions.noDelay ? 0 : (*socketOptions.noDelay ? 1 : -1);
+        options.l_busy_poll = std::max(socketOptions.busyPoll, 0);
+        options.l_quickack = socketOptions.quickAck ? 1 : 0;
+        // a server that is gone without closing the connection would block a reconnecting receiver for good
+        options.l_keepalive = std::max(socketOptions.keepAlive.value_or(autoReconnect ? reconnectKeepAlive : 0), 0);
+        options.l_timeout = std::max(socketOptions.connectTimeout, 0);
+        f_evt_socket_options(channel, &options);
+        // a read without data returns GETEVT__TIMEOUT, see serverSilent(...)
+        if(socketOptions.readTimeout > 0)
+            f_evt_timeout(channel, socketOptions.readTimeout);
+    }
+}
+
+s_evt_channel* MbsClient::openServer(const std::string &server, INTS4 sourceType)
+{
+    s_evt_channel* channel = f_evt_control();
+    configureChannel(channel, sourceType);
+
+    // the MBS API takes a name with ':' for a RFIO file
+    std::string host = server;
+    const size_t colon = host.rfind(':');
+    if(colon != std::string::npos)
+    {
+        f_evt_server_port(channel, std::atoi(host.c_str() + colon + 1));
+        host.erase(colon);
+    }
+
+    if(f_evt_get_open(sourceType, host.c_str(), channel, nullptr,
+                      static_cast<INTS4>(eventSampleRate.load()), 0) != GETEVT__SUCCESS)
+    {
+        free(channel);
+        return nullptr;
+    }
+
+    logSocketOptions(channel, server);
+    return channel;
+}
+
+bool MbsClient::reconnectServer(s_evt_channel *&channel, int &socket, const std::string &server, INTS4 sourceType)
+{
+    const auto down = std::chrono::steady_clock::now();
+    connectionsDown++;
     {
-        auto fullpath = fs::path(filelist.back());
-        auto filename = fullpath.filename();
-        auto dirPath = fullpath.parent_path();
+        // disconnect() must not shut down the socket number once it is closed and maybe reused
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        socket = -1;
+        if(channel != nullptr)
+            f_evt_get_close(channel);
+    }
+    free(channel);
+    channel = nullptr;
 
-        // extract the file number from the file name. Format filename_number.lmd
-        auto underline_pos = filename.string().rfind('_');
-        if(underline_pos == std::string::npos)
+    std::chrono::milliseconds backoff = reconnectBackoff;
+    bool reconnected = false;
+    while(!disconnected)
+    {
+        std::cout << "MbsClient: the connection to " << server << " has ended, reconnect in "
+                  << backoff.count() << " ms." << std::endl;
+
+        // in short steps, disconnect() does not wait for the backoff
+        const auto attempt = std::chrono::steady_clock::now() + backoff;
+        while(!disconnected && std::chrono::steady_clock::now() < attempt)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if(disconnected)
+            break;
+
+        channel = openServer(server, sourceType);
+        if(channel != nullptr)
         {
-            std::cout << "MbsClient::connect: no '_' in filename found. "
-                      << "Can't extract the file number. Format: filename_number.lmd" << std::endl;
-            return;
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            socket = channel->l_channel_no;
+            reconnected = !disconnected;
+            break;
         }
-        std::string numberPart =  filename.string().substr(underline_pos+1, filename.string().size()-underline_pos-5);
-        uint32_t number = 0;
+        backoff = std::min(backoff*2, reconnectBackoffMax.load());
+    }
 
-        try
+    reconnectDowntime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - down).count();
+    connectionsDown--;
+    if(reconnected)
+    {
+        nReconnects++;
+        std::cout << "MbsClient: reconnected to " << server << "." << std::endl;
+    }
+    return reconnected;
+}
+
+bool MbsClient::serverSilent(std::optional<std::chrono::steady_clock::time_point> &silentSince)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if(!silentSince)
+        silentSince = now;
+
+    std::lock_guard<std::mutex> lock(socketOptionsMutex);
+    return socketOptions.readTimeout > 0 && now - *silentSince >= std::chrono::seconds(socketOptions.readTimeout);
+}
+
+void MbsClient::logSocketOptions(const s_evt_channel *channel, const std::string &name)
+{
+    s_stcopt options = {};
+    if(f_stc_getopt(channel->l_channel_no, &options) != STC__SUCCESS)
+        return;
+
+    std::cout << "MbsClient::connect: socket of " << name << ": SO_RCVBUF=" << options.l_rcvbuf
+              << " TCP_NODELAY=" << options.l_nodelay << " SO_BUSY_POLL=" << options.l_busy_poll
+              << " TCP_QUICKACK=" << options.l_quickack << " keepalive=" << options.l_keepalive << "s" << std::endl;
+}
+
+INTS4 MbsClient::serverType(ConnectionOption conOpt)
+{
+    switch(conOpt)
+    {
+    case ConnectionOption::stream:              return GETEVT__STREAM;
+    case ConnectionOption::transport:           return GETEVT__TRANS;
+    case ConnectionOption::eventServer:         return GETEVT__EVENT;
+    case ConnectionOption::remoteEventServer:   return GETEVT__REVSERV;
+    default:                                    return 0;
+    }
+}
+
+bool MbsClient::splitFileNumber(const std::string &filename, std::string &prefix, uint64_t &number)
+{
+    // format: filename_number.lmd
+    auto underline_pos = filename.rfind('_');
+    if(underline_pos == std::string::npos || filename.size() < underline_pos+6
+       || filename.compare(filename.size()-4, 4, ".lmd") != 0)
+        return false;
+
+    std::string numberPart = filename.substr(underline_pos+1, filename.size()-underline_pos-5);
+    if(!std::all_of(numberPart.begin(), numberPart.end(), ::isdigit))
+        return false;
+
+    try
+    {
+        number = std::stoull(numberPart, nullptr);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    prefix = filename.substr(0, underline_pos);
+    return true;
+}
+
+void MbsClient::newFileSeeker()
+{
+    fs::path fullpath;
+    {
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        fullpath = fs::path(filelist.back());
+    }
+
+    std::string prefix;
+    uint64_t number = 0;
+    if(!splitFileNumber(fullpath.filename().string(), prefix, number))
+    {
+        std::cout << "MbsClient::newFileSeeker: Can't extract the file number. "
+                  << "Format: filename_number.lmd" << std::endl;
+        stopFileSeeker();
+        return;
+    }
+
+    const size_t digits = fullpath.filename().string().size() - prefix.size() - 5;
+    const fs::path dirPath = fullpath.parent_path().empty() ? fs::path(".") : fullpath.parent_path();
+
+    auto nextFilePath = [&]()
+    {
+        std::stringstream ss;
+        ss << std::setw(digits) << std::setfill('0') << (number+1);
+        return dirPath / (prefix + "_" + ss.str() + ".lmd");
+    };
+
+    auto appendFile = [&](const fs::path &path)
+    {
+        std::cout << "Next LMD file '"<< path.string()
+                  <<"' will be opened automatically after the previous file is have been analyzed."<< std::endl;
+
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        filelist.push_back(path.string());
+        filelistChanged.notify_all();
+    };
+
+#ifdef __linux__
+    // MBS closes or renames a file when it is complete. the watch reports this at once,
+    // the directory is not polled. files that are followed are taken as soon as MBS creates them
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | (followFile ? IN_CREATE : 0);
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(fd >= 0 && inotify_add_watch(fd, dirPath.c_str(), mask) >= 0)
+    {
+        // files completed before the watch was added
+        for(auto path = nextFilePath(); fs::exists(path); path = nextFilePath())
         {
-            number = std::stoul(numberPart, nullptr);
+            number++;
+            appendFile(path);
         }
-        catch(...)
+
+        alignas(struct inotify_event) char events[4096];
+        while(!disconnected)
         {
-            std::cout << "MbsClient::connect: Can't extract the file number." << std::endl;
-            return;
+            // the timeout only serves to notice disconnect()
+            pollfd pfd = {fd, POLLIN, 0};
+            if(poll(&pfd, 1, 200) <= 0)
+                continue;
+
+            ssize_t length = read(fd, events, sizeof(events));
+            if(length <= 0)
+                continue;
+
+            // a single read may report several files, queue them in the order of their numbers
+            std::vector<std::pair<uint64_t, std::string>> newFiles;
+            for(ssize_t pos = 0; pos < length;)
+            {
+                auto event = reinterpret_cast<const struct inotify_event*>(events + pos);
+                pos += sizeof(struct inotify_event) + event->len;
+
+                std::string eventPrefix;
+                uint64_t eventNumber = 0;
+                if(event->len > 0 && splitFileNumber(event->name, eventPrefix, eventNumber)
+                   && eventPrefix == prefix && eventNumber > number)
+                    newFiles.emplace_back(eventNumber, event->name);
+            }
+
+            std::sort(newFiles.begin(), newFiles.end());
+            for(const auto &file : newFiles)
+            {
+                if(file.first <= number)
+                    continue;
+                number = file.first;
+                appendFile(dirPath / file.second);
+            }
         }
 
-        std::stringstream ss;
-        ss << std::setw(numberPart.size()) << std::setfill('0') << (number+1);
+        close(fd);
+        stopFileSeeker();
+        return;
+    }
 
-        std::string nextFilePath = dirPath.string() + "/"
-                + filename.string().substr(0, underline_pos) + "_" + ss.str() + ".lmd";
+    std::cout << "MbsClient::newFileSeeker: can't watch '" << dirPath.string()
+              << "' (" << strerror(errno) << "), look for the next file every 100 ms." << std::endl;
+    if(fd >= 0)
+        close(fd);
+#endif
 
-        if(fs::exists(nextFilePath))
+    while(!disconnected)
+    {
+        auto path = nextFilePath();
+        if(fs::exists(path))
         {
-            std::cout << "Next LMD file '"<< nextFilePath
-                      <<"' will be opened automatically after the previous file is have been analyzed."<< std::endl;
+            number++;
+            appendFile(path);
+        }
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    stopFileSeeker();
+}
 
-            // acquire lock
-            std::unique_lock<std::mutex> ulock(filelistMutex);
+void MbsClient::stopFileSeeker()
+{
+    std::lock_guard<std::mutex> lock(filelistMutex);
+    seekingFiles = false;
+    filelistChanged.notify_all();
+}
+
+void MbsClient::watchFile(const std::string &path)
+{
+    unwatchFile();
+    followClosed = false;
+
+#ifdef __linux__
+    followWatch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(followWatch >= 0 && inotify_add_watch(followWatch, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0)
+    {
+        std::cout << "MbsClient::watchFile: can't watch '" << path << "' (" << strerror(errno)
+                  << "), look for new data every 100 ms." << std::endl;
+        unwatchFile();
+    }
+#endif
+}
+
+void MbsClient::unwatchFile()
+{
+#ifdef __linux__
+    if(followWatch >= 0)
+        close(followWatch);
+#endif
+    followWatch = -1;
+}
+
+bool MbsClient::waitForFileData()
+{
+    // the writer has closed the file and what it wrote last is read already
+    if(followClosed || disconnected)
+        return false;
+
+    // MBS creates the next file after it has closed this one. read the end of the file once more
+    {
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        followClosed = filelist.size() > currentFileIndex+1;
+    }
+    if(followClosed)
+        return true;
 
-            filelist.push_back(nextFilePath);
+#ifdef __linux__
+    if(followWatch >= 0)
+    {
+        // the timeout covers writes that are not reported, e.g. from another host of a network file system
+        pollfd pfd = {followWatch, POLLIN, 0};
+        if(poll(&pfd, 1, 100) > 0)
+        {
+            alignas(struct inotify_event) char events[1024];
+            ssize_t length = read(followWatch, events, sizeof(events));
+            for(ssize_t pos = 0; pos < length;)
+            {
+                auto event = reinterpret_cast<const struct inotify_event*>(events + pos);
+                pos += sizeof(struct inotify_event) + event->len;
+                if(event->mask & IN_CLOSE_WRITE)
+                    followClosed = true;
+            }
         }
-		else
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return true;
     }
+#endif
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return true;
 }
 
+bool MbsClient::openFollowedFile(const std::string &path)
+{
+    watchFile(path);
 
+    // MBS has just created the file, the file header or the first buffer may still be missing
+    while(!openLmdFile(path, GETEVT__FILE))
+    {
+        if(!waitForFileData())
+            return false;
+    }
+    return true;
+}
 
-bool MbsClient::disconnect()
+bool MbsClient::takeNextFile(std::string &path, bool wait)
 {
-    // acquire lock
-    std::unique_lock<std::mutex> lock(queueMutex);
+    std::unique_lock<std::mutex> lock(filelistMutex);
+    if(wait)
+        filelistChanged.wait(lock, [this]()
+            { return disconnected || !seekingFiles || filelist.size() > currentFileIndex+1; });
 
+    if(disconnected || filelist.size() <= currentFileIndex+1)
+        return false;
+
+    currentFileIndex++;
+    path = filelist.at(currentFileIndex);
+    return true;
+}
+
+bool MbsClient::disconnect()
+{
     disconnected = true;
-    lock.unlock();
+    broadcast->finished = true;
+    notifyEventWaiters(true);
+    notifySubscribers(true);
+    notifyReceiver(true);
+    {
+        std::lock_guard<std::mutex> lock(broadcast->writerMutex);
+        broadcast->writerWakeup.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        batchReturned.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(filelistMutex);
+        filelistChanged.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        mergeWakeup.notify_one();
+    }
+#ifdef __linux__
+    {
+        // wake the receiverThread waiting for its server, the read fails then
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if(serverSocket >= 0)
+            shutdown(serverSocket, SHUT_RD);
+        serverSocket = -1;
+    }
+#endif
 
     for(size_t i = 0; i < receiverThread.size();i++)
     {
         receiverThread.at(i).join();
     }
     receiverThread.clear();
+    stopMergeSources();
+
+    stopBatchWorkers();
+    stopDecodeWorkers();
 
     for(size_t i = 0; i < fileseekThread.size();i++)
     {
         fileseekThread.at(i).join();
     }
     fileseekThread.clear();
+    unwatchFile();
 
     if(inputChannel != nullptr)
         f_evt_get_close(inputChannel);
+    free(inputChannel);
     inputChannel = nullptr;
 
+    // records in the event buffer keep their chunks alive
+    receiverArena = RecordArena();
+
     fileHeader = nullptr;
     bufferHeader = nullptr;
     mbsSource = "not connected";
@@ -248,138 +730,1356 @@ void MbsClient::setBufferLimit(size_t maxEventBufferSize)
     this->maxEventBufferSize = maxEventBufferSize;
 }
 
-void MbsClient::eventReceiver()
+void MbsClient::setMemoryLimit(size_t maxBytes, size_t lowWatermark)
 {
-    int32_t *eventData = nullptr;
-    int mess = 0;
-    while(inputChannel != nullptr && disconnected==false)
-    {
-        int32_t result = 0;
-        eventData = nullptr;
-        result = f_evt_get_event(inputChannel, &eventData, (INTS4**) (&bufferHeader));
+    if(lowWatermark == 0 || lowWatermark > maxBytes)
+        lowWatermark = maxBytes/4*3;
 
-        if(result == GETEVT__NOMORE)
-        {
-            std::cout << "size_of_received_data=" << sizeOfReceivedData << std::endl
-                      << "Close "<<mbsSource << std::endl;
-            f_evt_get_close(inputChannel);
+    maxBytesInBuffer = maxBytes;
+    lowWatermarkBytes = lowWatermark;
 
-            if(filelist.size() > currentFileIndex+1)
-            {
-                currentFileIndex++;
-                std::string next_mbs_source = filelist.at(currentFileIndex);
+    // the receiver may wait for a lower limit
+    notifyReceiver(false);
+}
 
-                std::cout << "Try to open " << next_mbs_source<< std::endl;
+void MbsClient::setFileReadMode(FileReadMode mode)
+{
+    fileReadMode = mode;
+}
 
-                if(!openLmdFile(next_mbs_source, GETEVT__FILE))
-                {
-                    std::cout << "error: if(!openLmdFile(next_mbs_source, GETEVT__FILE)). next_mbs_source="
-                              << next_mbs_source << std::endl;
-                    return;
-                }
-            }
-            else
-            {
-                noMoreEvents = true;
-            }
-        }
+void MbsClient::setFileFollow(bool follow)
+{
+    followFiles = follow;
+}
 
+void MbsClient::setStreamRequestDepth(size_t depth)
+{
+    streamRequestDepth = std::min(depth, size_t(64));
+}
 
-        if(result == GETEVT__FRAGMENT && mess < 10)
-        {
-            std::cout << "event fragment found..." << std::endl;
-            std::cout << "f_evt_type(...) output: " << std::endl;
-            f_evt_type(bufferHeader, (s_evhe*) eventData, -1, 0, 1, 0);
-            std::cout << "----------------------------------------------------" << std::endl;
-            mess++;
-        }
+void MbsClient::setEventSampleRate(size_t n)
+{
+    eventSampleRate = std::min(std::max(n, size_t(1)), size_t(1000000));
+}
 
-        if(result != GETEVT__SUCCESS)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // wait to reduce CPU load
-            continue;
-        }
+void MbsClient::setSocketOptions(const SocketOptions &options)
+{
+    std::lock_guard<std::mutex> lock(socketOptionsMutex);
+    socketOptions = options;
+}
 
-        noMoreEvents = false;
-        if(nEventsInBuffer > maxEventBufferSize)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50)); // wait to reduce CPU load
-        }
+void MbsClient::setAutoReconnect(bool on, std::chrono::milliseconds initialBackoff, std::chrono::milliseconds maxBackoff)
+{
+    initialBackoff = std::max(initialBackoff, std::chrono::milliseconds(1));
+    reconnectBackoff = initialBackoff;
+    reconnectBackoffMax = std::max(maxBackoff, initialBackoff);
+    autoReconnect = on;
+}
 
-        // uncomment the following lines to output the "raw data and header info from the event"
-        /*
-        if(mess > 0)
-        {
-            std::cout << "f_evt_type(...) output: " << std::endl;
-            f_evt_type(bufferHeader, (s_evhe*) eventData, -1, 0, 1, 0);
-            std::cout << "----------------------------------------------------" << std::endl;
-        }*/
-        uint64_t mbsTimestamp = static_cast<uint64_t>(bufferHeader->l_time[0])*1000
-                                    + static_cast<uint64_t>(bufferHeader->l_time[1]);
-        // if(this->eventBuffer.size()==0)
-        //    std::cout << bufferHeader->l_time[0] << " "<< bufferHeader->l_time[1] << "  " << mbsTimestamp << std::endl;
+void MbsClient::setFileBlockSize(size_t bytes, size_t readAheadBlocks)
+{
+    fileBlockSize = std::min(bytes, size_t(1) << 30);
+    fileReadAheadBlocks = std::min(readAheadBlocks, size_t(256));
+}
 
-        MbsEvent mbsevent;
-        mbsevent.timestamp = mbsTimestamp;
+void MbsClient::setDecodeThreads(size_t nThreads)
+{
+    if(isConnected())
+    {
+        std::cout << "MbsClient::setDecodeThreads: can't change the decode threads while connected. ignore." << std::endl;
+        return;
+    }
 
-        // acquire lock
-        std::unique_lock<std::mutex> ulock(queueMutex); 
-        for(int sub = 1; result != GETEVT__NOMORE; ++sub)
-        {
-            s_ves10_1 *subeventHeader = nullptr;
-            int32_t *data = nullptr;
-            int32_t dataLength = 0;
+    nDecodeThreads = std::min<size_t>(nThreads, 256);
+}
 
-            result = f_evt_get_subevent((s_ve10_1*) eventData, sub,
-                                        (int32_t**) &subeventHeader, &data, &dataLength);
-            if(result == GETEVT__SUCCESS)
-            {
-                if(dataLength > 0)
-                {
-                    mbsevent.data.assign(data, data+dataLength);
-                    eventBuffer.push_back(mbsevent);
+void MbsClient::resizeEventBuffer()
+{
+    subeventLimit = maxEventBufferSize;
 
-                    sizeOfReceivedData += dataLength*sizeof(int32_t);
-                    nReceivedEvents++;
-                }
-            }
+    {
+        std::lock_guard<std::mutex> lock(broadcast->subscriberMutex);
+        broadcast->subscribers.erase(std::remove_if(broadcast->subscribers.begin(), broadcast->subscribers.end(),
+                                                    [](const std::weak_ptr<Subscription>& s) { return s.expired(); }),
+                                     broadcast->subscribers.end());
+        fanOut = !broadcast->subscribers.empty();
+        broadcast->finished = false;
+
+        size_t capacity = broadcast->ring.capacity();
+        if(fanOut && !(capacity >= maxEventBufferSize && capacity/2 < maxEventBufferSize))
+        {
+            // the subscriptions must not read during connect(...)
+            broadcast->ring.resize(maxEventBufferSize);
+            broadcast->publishedSubevents = 0;
+            broadcast->slowestCursor = 0;
+            for(auto& s : broadcast->subscribers)
+                if(auto subscription = s.lock())
+                    subscription->cursor = 0;
         }
-
-        nEventsInBuffer = eventBuffer.size();
+    }
+
+    if(eventBuffer.capacity() >= maxEventBufferSize && eventBuffer.capacity()/2 < maxEventBufferSize)
+        return;
+
+    if(eventBuffer.size() > 0)
+    {
+        std::cout << "MbsClient::connect: the event buffer is not empty. "
+                  << "Keep the old buffer limit of " << eventBuffer.capacity() << " events." << std::endl;
+        return;
+    }
+
+    eventBuffer.resize(maxEventBufferSize);
+}
+
+std::shared_ptr<char> MbsClient::allocateRecord(size_t bytes, RecordArena &arena)
+{
+    // the next record in the chunk must be aligned like the header
+    bytes = (bytes + alignof(MbsEventRecord::Header) - 1) & ~(alignof(MbsEventRecord::Header) - 1);
+
+    if(bytes > recordChunkSize/4)
+        return std::shared_ptr<char>(new char[bytes], std::default_delete<char[]>());
+
+    if(!arena.chunk || arena.used + bytes > recordChunkSize)
+    {
+        arena.chunk = recordPool.acquire(recordChunkSize);
+        arena.used = 0;
+    }
+
+    // shares the ownership of the chunk
+    std::shared_ptr<char> block(arena.chunk, arena.chunk.get() + arena.used);
+    arena.used += bytes;
+    return block;
+}
+
+MbsClient::MbsEventRecord MbsClient::makeRecord(const s_ve10_1* event, uint64_t timestamp, bool swapData,
+                                                RecordArena &arena, int16_t serverIndex)
+{
+    SubeventRange range(event, swapData);
+
+    uint32_t nSubevents = 0;
+    uint32_t nWords = 0;
+    SubeventRange::iterator it = range.begin();
+    for(; it != range.end(); ++it)
+    {
+        nSubevents++;
+        nWords += it->size;
+    }
+
+    if(it.broken() && nMalformedEvents++ < 10)
+    {
+        std::cout << "MbsClient::makeRecord: a subevent exceeds the length of event " << event->l_count
+                  << ". The rest of the event is dropped." << std::endl;
+    }
+
+    const size_t bytes = MbsEventRecord::blockSize(nSubevents, nWords);
+    std::shared_ptr<char> block = allocateRecord(bytes, arena);
+
+    MbsEventRecord::Header* header = new(block.get()) MbsEventRecord::Header();
+    header->timestamp = timestamp;
+    header->bytes = bytes;
+    header->count = event->l_count;
+    header->nSubevents = nSubevents;
+    header->nWords = nWords;
+    header->type = event->i_type;
+    header->subtype = event->i_subtype;
+    header->trigger = event->i_trigger;
+    header->source = serverIndex;
+
+    SubeventDescriptor* table = reinterpret_cast<SubeventDescriptor*>(header + 1);
+    uint32_t* payload = reinterpret_cast<uint32_t*>(table + nSubevents);
+    uint32_t offset = 0;
+    for(const MbsSubevent& source : range)
+    {
+        SubeventDescriptor& subevent = *table++;
+        subevent.offset = offset;
+        subevent.length = source.size;
+        subevent.type = source.header->i_type;
+        subevent.subtype = source.header->i_subtype;
+        subevent.procid = source.header->i_procid;
+        subevent.subcrate = source.header->h_subcrate;
+        subevent.control = source.header->h_control;
+
+        source.copyData(payload + offset);
+        offset += source.size;
+    }
+
+    return MbsEventRecord(std::shared_ptr<const MbsEventRecord::Header>(block, header));
+}
+
+void MbsClient::eventReceiver()
+{
+    int32_t *eventData = nullptr;
+    int mess = 0;
+    std::optional<std::chrono::steady_clock::time_point> silentSince;
+    while(inputChannel != nullptr && disconnected==false)
+    {
+        int32_t result = 0;
+        eventData = nullptr;
+        if(decodeBlocks)
+        {
+            bool stopped = false;
+            result = receiveBlocks(stopped);
+            if(stopped)
+                return;
+        }
+        else
+            result = f_evt_get_event(inputChannel, &eventData, (INTS4**) (&bufferHeader));
+
+        // no data for the moment: do not hold back the events collected so far
+        if(result != GETEVT__SUCCESS && currentBatch && !currentBatch->empty())
+            dispatchBatch();
+
+        // a followed file is at its end for the moment: wait for MBS to write more or to close the file
+        if(result == GETEVT__NOMORE && followFile && waitForFileData())
+            continue;
+
+        if(result == GETEVT__NOMORE)
+        {
+            std::cout << "size_of_received_data=" << sizeOfReceivedData << std::endl
+                      << "Close "<<mbsSource << std::endl;
+            f_evt_get_close(inputChannel);
+
+            std::string next_mbs_source;
+            if(!takeNextFile(next_mbs_source, false))
+            {
+                noMoreEvents = true;
+                broadcast->finished = true;
+                notifyEventWaiters(true);
+                notifySubscribers(true);
+
+                // the fileseekThread may still find the next file
+                if(!takeNextFile(next_mbs_source, true))
+                    return;
+            }
+
+            std::cout << "Try to open " << next_mbs_source<< std::endl;
+
+            if(followFile ? !openFollowedFile(next_mbs_source) : !openLmdFile(next_mbs_source, GETEVT__FILE))
+            {
+                std::cout << "error: if(!openLmdFile(next_mbs_source, GETEVT__FILE)). next_mbs_source="
+                          << next_mbs_source << std::endl;
+                noMoreEvents = true;
+                broadcast->finished = true;
+                notifyEventWaiters(true);
+                notifySubscribers(true);
+                return;
+            }
+            continue;
+        }
+
+        // the server has closed the connection, has sent its shutdown notice or is gone
+        const bool silent = inputType != GETEVT__FILE && result == GETEVT__TIMEOUT && serverSilent(silentSince);
+        if(inputType != GETEVT__FILE && (result == GETEVT__RDERR || result == GETEVT__FAILURE || silent))
+        {
+            if(silent)
+                std::cout << "MbsClient: no events from " << mbsSource << " within the read timeout." << std::endl;
+            silentSince.reset();
+            // they point into the channel
+            fileHeader = nullptr;
+            bufferHeader = nullptr;
+            if(autoReconnect && reconnectServer(inputChannel, serverSocket, mbsSource, inputType))
+                continue;
+            if(disconnected)
+                return;
+
+            std::cout << "size_of_received_data=" << sizeOfReceivedData << std::endl
+                      << "MbsClient: the connection to " << mbsSource << " has ended." << std::endl;
+            noMoreEvents = true;
+            broadcast->finished = true;
+            notifyEventWaiters(true);
+            notifySubscribers(true);
+            return;
+        }
+
+        if(result == GETEVT__FRAGMENT && mess < 10)
+        {
+            std::cout << "event fragment found..." << std::endl;
+            std::cout << "f_evt_type(...) output: " << std::endl;
+            f_evt_type(bufferHeader, (s_evhe*) eventData, -1, 0, 1, 0);
+            std::cout << "----------------------------------------------------" << std::endl;
+            mess++;
+        }
+
+        if(result != GETEVT__SUCCESS)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // wait to reduce CPU load
+            continue;
+        }
+
+        // uncomment the following lines to output the "raw data and header info from the event"
+        /*
+        if(mess > 0)
+        {
+            std::cout << "f_evt_type(...) output: " << std::endl;
+            f_evt_type(bufferHeader, (s_evhe*) eventData, -1, 0, 1, 0);
+            std::cout << "----------------------------------------------------" << std::endl;
+        }*/
+        // the whole event is copied once, the MBS API reuses its buffers with the next call
+        silentSince.reset();
+        MbsEventRecord record = makeRecord(reinterpret_cast<const s_ve10_1*>(eventData), bufferTimestamp(bufferHeader),
+                                           inputChannel->l_evt_swap == 1, receiverArena);
+        if(!commitRecord(std::move(record)))
+            return;
     }
 
     if(disconnected)
         return;
 }
 
-void MbsClient::clearEventBuffer()
+uint64_t MbsClient::bufferTimestamp(const s_bufhe *header)
 {
-    // acquire the mutex lock
-    std::unique_lock<std::mutex> ulock(queueMutex);
+    // files in the newer LMD format have no buffer headers
+    if(header == nullptr)
+        return 0;
+
+    return static_cast<uint64_t>(header->l_time[0])*1000 + static_cast<uint64_t>(header->l_time[1]);
+}
 
-    if(ulock.owns_lock())
+bool MbsClient::commitRecord(MbsEventRecord &&record)
+{
+    noMoreEvents = false;
+    broadcast->finished.store(false, std::memory_order_relaxed);
+
+    for(const SubeventDescriptor& subevent : record)
     {
-        eventBuffer.clear();
-        nEventsInBuffer = 0;
+        if(subevent.length > 0)
+        {
+            sizeOfReceivedData += subevent.length*sizeof(int32_t);
+            nReceivedEvents++;
+        }
     }
+
+    if(!pushEvent(std::move(record)))
+        return false;
+
+    notifyEventWaiters(false);
+    return true;
 }
 
-void MbsClient::getEventData(std::vector<MbsClient::MbsEvent> &dest, size_t nElementsToCopy)
+void MbsClient::sourceReceiver(MergeSource &source)
+{
+    RecordArena arena;
+    std::optional<std::chrono::steady_clock::time_point> silentSince;
+    while(disconnected == false)
+    {
+        int32_t *eventData = nullptr;
+        s_bufhe *header = nullptr;
+        int32_t result = f_evt_get_event(source.channel, &eventData, (INTS4**) (&header));
+
+        const bool silent = result == GETEVT__TIMEOUT && serverSilent(silentSince);
+        if((result == GETEVT__TIMEOUT && !silent) || result == GETEVT__FRAGMENT)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // wait to reduce CPU load
+            continue;
+        }
+        if(result != GETEVT__SUCCESS)
+        {
+            if(silent)
+                std::cout << "MbsClient: no events from " << source.name << " within the read timeout." << std::endl;
+            silentSince.reset();
+            if(autoReconnect && reconnectServer(source.channel, source.socket, source.name, source.type))
+                continue;
+            if(!disconnected)
+                std::cout << "MbsClient: the connection to " << source.name << " has ended." << std::endl;
+            break;
+        }
+
+        silentSince.reset();
+        MbsEventRecord record = makeRecord(reinterpret_cast<const s_ve10_1*>(eventData), bufferTimestamp(header),
+                                           source.channel->l_evt_swap == 1, arena, source.index);
+
+        // the receiverThread waits for the event buffer or for the other servers
+        while(!source.queue.push(std::move(record)))
+        {
+            if(disconnected)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        notifyMerger();
+    }
+
+    source.finished = true;
+    notifyMerger();
+}
+
+void MbsClient::notifyMerger()
+{
+    // the event pushed before must be visible to a receiverThread that checks the queues after setting mergerWaits
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(mergerWaits)
+    {
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        mergeWakeup.notify_one();
+    }
+}
+
+bool MbsClient::mergesBefore(const MbsEventRecord &a, const MbsEventRecord &b) const
 {
-    // acquire the mutex lock
-    std::unique_lock<std::mutex> ulock(queueMutex, std::try_to_lock);
+    if(mergeOrder == MergeOrder::timestamp)
+        return a.timestamp() < b.timestamp();
+
+    // the event number wraps around
+    return static_cast<int32_t>(a.count() - b.count()) < 0;
+}
 
-    if(ulock.owns_lock())
+void MbsClient::mergeReceiver()
+{
+    size_t nStaged = 0;     // events taken from the queues, but not committed yet
+    while(disconnected == false)
     {
-        nElementsToCopy = std::min<size_t>(nElementsToCopy, eventBuffer.size());
-        if(nElementsToCopy > 0)
+        for(auto& source : mergeSources)
         {
-            dest.insert(dest.end(), std::make_move_iterator(eventBuffer.begin()), std::make_move_iterator(eventBuffer.begin()+nElementsToCopy));
-            eventBuffer.erase(eventBuffer.begin(), eventBuffer.begin()+nElementsToCopy);          
+            // the last events of an ended source are in its queue before finished is set
+            const bool finished = source->finished;
+
+            // at least the next event of each source, to compare it with the others
+            size_t n = SIZE_MAX;
+            if(mergeOrder != MergeOrder::arrival)
+                n = std::max<size_t>(mergeWindow > nStaged ? mergeWindow - nStaged : 0, source->staged.empty() ? 1 : 0);
+            nStaged += source->queue.pop(std::back_inserter(source->staged), n);
+            source->drained = finished && source->queue.empty();
         }
 
-        nEventsInBuffer = eventBuffer.size();
+        size_t nCommitted = 0;
+        if(mergeOrder == MergeOrder::arrival)
+        {
+            for(auto& source : mergeSources)
+            {
+                for(; !source->staged.empty(); source->staged.pop_front(), nStaged--, nCommitted++)
+                    if(!commitRecord(std::move(source->staged.front())))
+                        return;
+            }
+        }
+        else
+        {
+            for(;;)
+            {
+                // the smallest next event. it is certain, if each source that can still send has an event staged
+                MergeSource* next = nullptr;
+                bool complete = true;
+                for(auto& source : mergeSources)
+                {
+                    if(source->staged.empty())
+                    {
+                        complete = complete && source->drained;
+                        continue;
+                    }
+                    if(next == nullptr || mergesBefore(source->staged.front(), next->staged.front()))
+                        next = source.get();
+                }
+                if(next == nullptr || (!complete && nStaged < mergeWindow))
+                    break;
+
+                if(!commitRecord(std::move(next->staged.front())))
+                    return;
+                next->staged.pop_front();
+                nStaged--;
+                nCommitted++;
+            }
+        }
+
+        if(std::all_of(mergeSources.begin(), mergeSources.end(),
+                       [](const std::unique_ptr<MergeSource>& source) { return source->drained && source->staged.empty(); }))
+        {
+            std::cout << "size_of_received_data=" << sizeOfReceivedData << std::endl
+                      << "All connections have ended." << std::endl;
+            if(currentBatch && !currentBatch->empty())
+                dispatchBatch();
+            noMoreEvents = true;
+            broadcast->finished = true;
+            notifyEventWaiters(true);
+            notifySubscribers(true);
+            return;
+        }
+
+        if(nCommitted > 0)
+            continue;
+
+        // no data for the moment: do not hold back the events collected so far
+        if(currentBatch && !currentBatch->empty())
+            dispatchBatch();
+
+        mergerWaits = true;
+        {
+            std::unique_lock<std::mutex> lock(mergeMutex);
+            mergeWakeup.wait_for(lock, std::chrono::milliseconds(100), [this]()
+            {
+                return disconnected || std::any_of(mergeSources.begin(), mergeSources.end(),
+                                                   [](const std::unique_ptr<MergeSource>& source)
+                                                   { return !source->queue.empty() || (source->finished && !source->drained); });
+            });
+        }
+        mergerWaits = false;
+    }
+}
+
+void MbsClient::stopMergeSources()
+{
+#ifdef __linux__
+    // wake the source threads waiting for their servers, the read fails then
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        for(auto& source : mergeSources)
+            if(!source->finished && source->socket >= 0)
+                shutdown(source->socket, SHUT_RD);
+    }
+#endif
+
+    for(auto& source : mergeSources)
+    {
+        if(source->thread.joinable())
+            source->thread.join();
+        if(source->channel != nullptr)
+            f_evt_get_close(source->channel);
+        free(source->channel);
     }
+    mergeSources.clear();
+}
+
+void MbsClient::startDecodeWorkers()
+{
+    decodeStop = false;
+    for(size_t i = 0; i < nDecodeThreads; i++)
+        decodeWorkers.push_back(std::thread(&MbsClient::decodeWorker, this));
+}
+
+void MbsClient::stopDecodeWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        decodeStop = true;
+    }
+    decodeWakeup.notify_all();
+
+    for(size_t i = 0; i < decodeWorkers.size(); i++)
+        decodeWorkers.at(i).join();
+    decodeWorkers.clear();
+    decodeFreeJobs.clear();
+}
+
+void MbsClient::decodeWorker()
+{
+    RecordArena arena;
+    std::unique_lock<std::mutex> lock(decodeMutex);
+    while(true)
+    {
+        decodeWakeup.wait(lock, [this]() { return decodeStop || !decodeQueue.empty(); });
+        if(decodeQueue.empty())
+            return;
+
+        DecodeJob& job = *decodeQueue.front();
+        decodeQueue.pop_front();
+        lock.unlock();
+
+        // the same swap as f_evt_get_event(...) does for a block, but in parallel.
+        // a mapped block is swapped into its copy, a swap in place would copy the pages of the mapping
+        if(job.swap && job.buffer && job.block != job.buffer.get())
+        {
+            const size_t swapped = job.bytes - job.bytes%4;
+            f_ut_swap4(job.block, swapped/4, job.buffer.get());
+            std::memcpy(job.buffer.get() + swapped, job.block + swapped, job.bytes - swapped);
+            job.block = job.buffer.get();
+            f_evt_swap(job.block + swapped, static_cast<INTS4>(job.bytes - swapped));
+        }
+        else if(job.swap)
+            f_evt_swap(job.block, static_cast<INTS4>(job.bytes));
+
+        job.decoder.speculate(job.block, job.bytes, [this, &job, &arena](const s_ve10_1* event, const s_bufhe* header)
+        {
+            job.records.push_back(makeRecord(event, bufferTimestamp(header), false, arena));
+        });
+
+        lock.lock();
+        job.done = true;
+        decodeDone.notify_one();
+    }
+}
+
+INTS4 MbsClient::receiveBlocks(bool &stopped)
+{
+    // two blocks per worker: one to decode, one waiting
+    const size_t maxBlocksInFlight = 2*decodeWorkers.size();
+    INTS4 result = GETEVT__SUCCESS;
+
+    // after a refused event the rest of the blocks is dropped
+    stopped = false;
+    auto commit = [this, &stopped](const s_ve10_1* event, const s_bufhe* header)
+    {
+        if(!stopped && !commitRecord(makeRecord(event, bufferTimestamp(header), false, receiverArena)))
+            stopped = true;
+    };
+
+    auto waitForJob = [this](DecodeJob& job)
+    {
+        std::unique_lock<std::mutex> lock(decodeMutex);
+        decodeDone.wait(lock, [&job]() { return job.done; });
+    };
+
+    while(!disconnected)
+    {
+        while(result == GETEVT__SUCCESS && decodeInFlight.size() < maxBlocksInFlight)
+        {
+            CHARS* block = nullptr;
+            INTS4 bytes = 0;
+            INTS4 swap = 0;
+            result = f_evt_get_block(inputChannel, &block, &bytes, &swap);
+            if(result != GETEVT__SUCCESS)
+                break;
+
+            std::unique_ptr<DecodeJob> job;
+            if(decodeFreeJobs.empty())
+                job = std::make_unique<DecodeJob>();
+            else
+            {
+                job = std::move(decodeFreeJobs.back());
+                decodeFreeJobs.pop_back();
+            }
+
+            job->block = block;
+            job->bytes = static_cast<size_t>(bytes);
+            job->swap = swap == 1;
+            job->decoder.reset(inputChannel->l_buf_size);
+            job->done = false;
+
+            // a block in the mapping of the file stays valid until the file is closed,
+            // any other block is overwritten by the next read.
+            // a mapped block that needs a swap is copied by the worker while it swaps
+            const bool mapped = inputChannel->pc_map != nullptr && block >= inputChannel->pc_map
+                                && block < inputChannel->pc_map + inputChannel->l_map_size;
+            if(!mapped || job->swap)
+                job->buffer = blockPool.acquire(inputChannel->l_io_buf_max);
+            if(!mapped)
+            {
+                std::memcpy(job->buffer.get(), block, job->bytes);
+                job->block = job->buffer.get();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(decodeMutex);
+                decodeQueue.push_back(job.get());
+            }
+            decodeWakeup.notify_one();
+            decodeInFlight.push_back(std::move(job));
+        }
+
+        if(decodeInFlight.empty())
+            break;
+
+        DecodeJob& job = *decodeInFlight.front();
+        waitForJob(job);
+
+        // the spanned event from the previous block first, then the events of the block.
+        // if the worker assumed a wrong state, e.g. for the first block of a file, the block is decoded again
+        if(blockDecoder.join(job.decoder, commit))
+        {
+            for(size_t i = 0; i < job.records.size() && !stopped; i++)
+                stopped = !commitRecord(std::move(job.records[i]));
+        }
+        else
+            blockDecoder.decode(job.block, job.bytes, commit);
+
+        job.records.clear();
+        job.buffer.reset();
+        decodeFreeJobs.push_back(std::move(decodeInFlight.front()));
+        decodeInFlight.pop_front();
+
+        if(stopped)
+            break;
+    }
+
+    // after a disconnect or a refused event the workers may still use the blocks
+    for(auto& job : decodeInFlight)
+    {
+        waitForJob(*job);
+        job->records.clear();
+        job->buffer.reset();
+        decodeFreeJobs.push_back(std::move(job));
+    }
+    decodeInFlight.clear();
+
+    if(blockDecoder.brokenBuffers() > 0 && result == GETEVT__NOMORE)
+    {
+        std::cout << "MbsClient::receiveBlocks: " << blockDecoder.brokenBuffers() << " buffers of " << mbsSource
+                  << " with an event fragment that exceeds the buffer. The rest of these buffers is dropped." << std::endl;
+    }
+
+    return disconnected ? GETEVT__FAILURE : result;
+}
+
+bool MbsClient::pushEvent(MbsEventRecord &&record)
+{
+    if(batchHandler)
+    {
+        if(!currentBatch && !(currentBatch = acquireBatch()))
+            return false;
+
+        currentBatch->append(record);
+        if(currentBatch->size() >= maxBatchEvents)
+            dispatchBatch();
+        return true;
+    }
+
+    if(fanOut)
+        return publishEvent(std::move(record));
+
+    // the buffer limits are hard limits: wait until the consumer makes space
+    size_t eventBytes = record.bytes();
+    if(!waitForBufferSpace(eventBytes))
+        return false;
+
+    // count before the push, so that the consumer never subtracts more than was added
+    subeventsInBuffer += countSubevents(record);
+    size_t bytes = bytesInBuffer.fetch_add(eventBytes) + eventBytes;
+    if(bytes > bytesInBufferHighWaterMark.load(std::memory_order_relaxed))
+        bytesInBufferHighWaterMark.store(bytes, std::memory_order_relaxed);
+    eventBuffer.push(std::move(record));
+    return true;
+}
+
+bool MbsClient::publishEvent(MbsEventRecord &&record)
+{
+    Broadcast& b = *broadcast;
+    const uint64_t seq = b.ring.published();   // written only by this thread
+    const size_t capacity = b.ring.capacity();
+
+    // the oldest event must be read by all lossless subscriptions before it is overwritten
+    if(seq - b.slowestCursor >= capacity)
+    {
+        auto hasSpace = [&]()
+        {
+            b.slowestCursor = slowestLosslessCursor(seq);
+            return seq - b.slowestCursor < capacity;
+        };
+
+        if(!hasSpace())
+        {
+            auto stallBegin = std::chrono::steady_clock::now();
+            {
+                std::unique_lock<std::mutex> lock(b.writerMutex);
+                b.writerWaits.store(true, std::memory_order_relaxed);
+                // pairs with the fence in Subscription::getEventViews(...)
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                // the ring will not grow anymore, a subscription waiting for more events has to take them now
+                notifySubscribers(true);
+                b.writerWakeup.wait(lock, [this, &hasSpace]() { return disconnected || hasSpace(); });
+                b.writerWaits.store(false, std::memory_order_relaxed);
+            }
+            receiverStallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - stallBegin).count();
+
+            if(disconnected)
+                return false;
+        }
+    }
+
+    const uint64_t subeventsBefore = b.publishedSubevents.load(std::memory_order_relaxed);
+    const size_t subevents = countSubevents(record);
+    b.ring.publish(Broadcast::Entry{std::move(record), subeventsBefore});
+    b.publishedSubevents.store(subeventsBefore + subevents, std::memory_order_release);
+    notifySubscribers(false);
+    return true;
+}
+
+uint64_t MbsClient::slowestLosslessCursor(uint64_t published)
+{
+    std::lock_guard<std::mutex> lock(broadcast->subscriberMutex);
+
+    uint64_t slowest = published;
+    auto& subscribers = broadcast->subscribers;
+    for(auto it = subscribers.begin(); it != subscribers.end();)
+    {
+        auto subscription = it->lock();
+        if(!subscription)
+        {
+            it = subscribers.erase(it);
+            continue;
+        }
+
+        if(subscription->policy == SubscriberPolicy::lossless)
+            slowest = std::min<uint64_t>(slowest, subscription->cursor.load(std::memory_order_acquire));
+        ++it;
+    }
+    return slowest;
+}
+
+void MbsClient::notifySubscribers(bool force)
+{
+    Broadcast& b = *broadcast;
+
+    // pairs with the fence in Subscription::waitForEvents(...)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(!force && b.publishedSubevents.load(std::memory_order_relaxed) < b.wakeSubevents.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(b.readerMutex);
+    b.wakeSubevents.store(UINT64_MAX, std::memory_order_relaxed);
+    b.readerWakeup.notify_all();
+}
+
+std::shared_ptr<MbsClient::Subscription> MbsClient::subscribe(SubscriberPolicy policy)
+{
+    std::shared_ptr<Subscription> subscription(new Subscription(broadcast, policy));
+
+    std::lock_guard<std::mutex> lock(broadcast->subscriberMutex);
+    subscription->cursor = broadcast->ring.published();
+    broadcast->subscribers.push_back(subscription);
+
+    if(!fanOut && isConnected())
+        std::cout << "MbsClient::subscribe: the subscription gets events after the next connect(...)." << std::endl;
+
+    return subscription;
+}
+
+MbsClient::Subscription::Subscription(std::shared_ptr<Broadcast> broadcast, SubscriberPolicy policy)
+    : broadcast(std::move(broadcast)), policy(policy)
+{
+}
+
+MbsClient::Subscription::~Subscription()
+{
+    // the receiver may wait for this subscription
+    std::lock_guard<std::mutex> lock(broadcast->writerMutex);
+    broadcast->writerWakeup.notify_one();
+}
+
+template<typename OutputIt>
+size_t MbsClient::Subscription::readRecords(OutputIt out, size_t n)
+{
+    Broadcast& b = *broadcast;
+    const size_t capacity = b.ring.capacity();
+
+    uint64_t pos = cursor.load(std::memory_order_relaxed);
+    uint64_t end = b.ring.published();
+    size_t nRead = 0;
+    Broadcast::Entry entry;
+    while(nRead < n && pos < end)
+    {
+        // a slot may be overwritten while it is read: keep a distance of one slot to the receiver
+        if(policy == SubscriberPolicy::dropOldest && end - pos >= capacity)
+        {
+            uint64_t oldest = end - capacity + 1;
+            droppedEvents += oldest - pos;
+            pos = oldest;
+            continue;
+        }
+
+        if(!b.ring.read(pos, entry))
+        {
+            // overwritten in the meantime, only possible for dropOldest
+            end = b.ring.published();
+            continue;
+        }
+
+        *out = std::move(entry.record);
+        ++out;
+        pos++;
+        nRead++;
+    }
+
+    cursor.store(pos, std::memory_order_release);
+
+    if(policy == SubscriberPolicy::lossless && nRead > 0)
+    {
+        // pairs with the fence in MbsClient::publishEvent(...)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(b.writerWaits.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(b.writerMutex);
+            b.writerWakeup.notify_one();
+        }
+    }
+
+    return nRead;
+}
+
+size_t MbsClient::Subscription::getEventRecords(std::vector<MbsClient::MbsEventRecord> &dest, size_t nEvents)
+{
+    return readRecords(std::back_inserter(dest), nEvents);
+}
+
+size_t MbsClient::Subscription::getEventViews(std::vector<MbsClient::MbsEventView> &dest, size_t n)
+{
+    return takeSubevents(partialRecord, n,
+                         [this](MbsEventRecord& record) { return readRecords(&record, 1) == 1; },
+                         [&dest](const MbsEventRecord& record, size_t i) { dest.push_back(record.view(i)); });
+}
+
+size_t MbsClient::Subscription::getEventData(std::vector<MbsClient::MbsEvent> &dest, size_t n)
+{
+    return takeSubevents(partialRecord, n,
+                         [this](MbsEventRecord& record) { return readRecords(&record, 1) == 1; },
+                         [this, &dest](const MbsEventRecord& record, size_t i)
+    {
+        const uint32_t* data = record.data(record[i]);
+        std::vector<uint32_t> payload = payloadPool.acquire(record[i].length);
+        payload.assign(data, data + record[i].length);
+        dest.push_back(MbsEvent{record.timestamp(), std::move(payload)});
+    });
+}
+
+size_t MbsClient::Subscription::getEventBatch(MbsClient::EventBatch &batch, size_t maxEvents)
+{
+    batch.clear();
+    return takeSubevents(partialRecord, maxEvents,
+                         [this](MbsEventRecord& record) { return readRecords(&record, 1) == 1; },
+                         [&batch](const MbsEventRecord& record, size_t i) { batch.append(record, i); });
+}
+
+bool MbsClient::Subscription::waitForEvents(size_t minCount, std::chrono::microseconds timeout)
+{
+    Broadcast& b = *broadcast;
+
+    // more events than the ring can hold will never be there, a record holds at least one subevent
+    minCount = std::max<size_t>(1, std::min<size_t>(minCount, b.ring.capacity() - 1));
+
+    // the receiverThread does not publish more events until a full lossless subscription reads
+    auto ready = [this, &b, minCount]()
+    {
+        return getEventsInBuffer() >= minCount || b.finished
+                || (policy == SubscriberPolicy::lossless
+                    && b.ring.published() - cursor.load(std::memory_order_relaxed) >= b.ring.capacity());
+    };
+    if(ready())
+        return true;
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(b.readerMutex);
+    while(true)
+    {
+        // the smallest wake target of all waiting subscriptions wins
+        uint64_t published = 0;
+        const uint64_t available = availableSubevents(published);
+        uint64_t target = published - available + minCount;
+        uint64_t current = b.wakeSubevents.load(std::memory_order_relaxed);
+        while(target < current && !b.wakeSubevents.compare_exchange_weak(current, target, std::memory_order_relaxed))
+            ;
+        // pairs with the fence in MbsClient::notifySubscribers(...)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if(ready())
+            return true;
+        if(b.readerWakeup.wait_until(lock, deadline) == std::cv_status::timeout)
+            return ready();
+    }
+}
+
+size_t MbsClient::Subscription::getEventsInBuffer() const
+{
+    uint64_t published = 0;
+    return static_cast<size_t>(availableSubevents(published));
+}
+
+uint64_t MbsClient::Subscription::availableSubevents(uint64_t &published) const
+{
+    const Broadcast& b = *broadcast;
+    const size_t capacity = b.ring.capacity();
+    const uint64_t partial = countSubevents(partialRecord.record, partialRecord.next);
+
+    uint64_t pos = cursor.load(std::memory_order_relaxed);
+    while(true)
+    {
+        // all records counted in published are below end
+        published = b.publishedSubevents.load(std::memory_order_acquire);
+        uint64_t end = b.ring.published();
+
+        // the records readRecords(...) would skip
+        if(policy == SubscriberPolicy::dropOldest && end - pos >= capacity)
+            pos = end - capacity + 1;
+        if(pos >= end)
+            return partial;
+
+        uint64_t subeventsBefore = 0;
+        if(b.ring.peek(pos, [&subeventsBefore](const Broadcast::Entry& entry) { subeventsBefore = entry.subeventsBefore; }))
+        {
+            // counts at least the records before pos
+            published = b.publishedSubevents.load(std::memory_order_acquire);
+            return published - subeventsBefore + partial;
+        }
+        // overwritten in the meantime, only possible for dropOldest
+    }
+}
+
+void MbsClient::setBatchHandler(std::function<void (const EventBatch &)> handler, size_t nThreads,
+                                size_t maxBatchEvents)
+{
+    if(isConnected())
+    {
+        std::cout << "MbsClient::setBatchHandler: can't change the batch handler while connected. ignore." << std::endl;
+        return;
+    }
+
+    batchHandler = std::move(handler);
+    nBatchThreads = std::max<size_t>(1, nThreads);
+    this->maxBatchEvents = std::max<size_t>(1, maxBatchEvents);
+}
+
+void MbsClient::startBatchWorkers()
+{
+    if(!batchHandler)
+        return;
+
+    // a batch can be returned to another worker than the one it came from
+    size_t nBatches = nBatchThreads*batchesPerWorker;
+
+    batchWorkersStop = false;
+    batchesInFlight = 0;
+    for(size_t i = 0; i < nBatchThreads; i++)
+    {
+        batchWorkers.push_back(std::make_unique<BatchWorker>());
+        BatchWorker& worker = *batchWorkers.back();
+        worker.pending.resize(nBatches);
+        worker.done.resize(nBatches);
+        for(size_t k = 0; k < batchesPerWorker; k++)
+            worker.done.push(std::make_unique<EventBatch>());
+    }
+
+    for(auto& worker : batchWorkers)
+        worker->thread = std::thread(&MbsClient::batchWorker, this, std::ref(*worker));
+}
+
+void MbsClient::stopBatchWorkers()
+{
+    batchWorkersStop = true;
+    for(auto& worker : batchWorkers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->wakeup.notify_one();
+        }
+        worker->thread.join();
+    }
+    batchWorkers.clear();
+    currentBatch.reset();
+    batchesInFlight = 0;
+}
+
+void MbsClient::batchWorker(BatchWorker &worker)
+{
+    std::unique_ptr<EventBatch> batch;
+    while(true)
+    {
+        if(worker.pending.pop(&batch, 1) == 0)
+        {
+            // the dispatched batches are processed before stopping
+            if(batchWorkersStop)
+                return;
+
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.idle.store(true, std::memory_order_relaxed);
+            // pairs with the fence in dispatchBatch()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            worker.wakeup.wait(lock, [&worker, this]() { return !worker.pending.empty() || batchWorkersStop; });
+            worker.idle.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        batchHandler(*batch);
+        batch->clear();
+        worker.done.push(std::move(batch));
+        batchesInFlight--;
+
+        // pairs with the fence in acquireBatch()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(receiverWaitsForBatch.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(batchMutex);
+            batchReturned.notify_one();
+        }
+    }
+}
+
+void MbsClient::dispatchBatch()
+{
+    BatchWorker* target = batchWorkers.front().get();
+    for(auto& worker : batchWorkers)
+        if(worker->pending.size() < target->pending.size())
+            target = worker.get();
+
+    batchesInFlight++;
+    target->pending.push(std::move(currentBatch));
+
+    // pairs with the fence in batchWorker(...)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(target->idle.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->wakeup.notify_one();
+    }
+}
+
+std::unique_ptr<MbsClient::EventBatch> MbsClient::acquireBatch()
+{
+    std::unique_ptr<EventBatch> batch;
+    auto takeBatch = [this, &batch]()
+    {
+        for(auto& worker : batchWorkers)
+            if(worker->done.pop(&batch, 1) > 0)
+                return true;
+        return false;
+    };
+
+    if(takeBatch())
+        return batch;
+
+    // all batches are in the work: wait for the slowest worker
+    auto stallBegin = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(batchMutex);
+        receiverWaitsForBatch.store(true, std::memory_order_relaxed);
+        // pairs with the fence in batchWorker(...)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        batchReturned.wait(lock, [this, &takeBatch]() { return disconnected || takeBatch(); });
+        receiverWaitsForBatch.store(false, std::memory_order_relaxed);
+    }
+    receiverStallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - stallBegin).count();
+
+    return batch;
+}
+
+void MbsClient::notifyEventWaiters(bool force)
+{
+    // pairs with the fence in waitForEventsInBuffer(...):
+    // either the consumer sees the new events or the receiver sees the threshold
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t threshold = wakeThreshold.load(std::memory_order_relaxed);
+    if(threshold == 0)
+        return;
+    size_t count = wakeOnRecords.load(std::memory_order_relaxed) ? eventBuffer.size() : subeventsInBuffer.load();
+    if(!force && count < threshold)
+        return;
+
+    std::lock_guard<std::mutex> lock(waitMutex);
+    eventsAvailable.notify_all();
+}
+
+bool MbsClient::waitForEventsInBuffer(size_t minCount, bool records, std::chrono::microseconds timeout)
+{
+    // more events than the buffer can hold will never be there
+    minCount = std::max<size_t>(1, std::min<size_t>(minCount, records ? eventBuffer.capacity() : subeventLimit.load()));
+
+    auto ready = [this, minCount, records]()
+    {
+        size_t count = records ? eventBuffer.size() : subeventsInBuffer.load();
+        return count >= minCount || readoutDone()
+                || parkedEventBytes.load(std::memory_order_relaxed) != noParkedEvent;
+    };
+    if(ready())
+        return true;
+
+    std::unique_lock<std::mutex> lock(waitMutex);
+    wakeOnRecords.store(records, std::memory_order_relaxed);
+    wakeThreshold.store(minCount, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool result = eventsAvailable.wait_for(lock, timeout, ready);
+    wakeThreshold.store(0, std::memory_order_relaxed);
+    return result;
+}
+
+size_t MbsClient::waitForEvents(std::vector<MbsClient::MbsEvent> &dest, size_t minCount, size_t maxCount,
+                                std::chrono::microseconds timeout)
+{
+    waitForEventsInBuffer(minCount, false, timeout);
+
+    size_t oldSize = dest.size();
+    getEventData(dest, maxCount);
+    return dest.size() - oldSize;
+}
+
+size_t MbsClient::waitForEvents(std::vector<MbsClient::MbsEventView> &dest, size_t minCount, size_t maxCount,
+                                std::chrono::microseconds timeout)
+{
+    waitForEventsInBuffer(minCount, false, timeout);
+
+    size_t oldSize = dest.size();
+    getEventViews(dest, maxCount);
+    return dest.size() - oldSize;
+}
+
+size_t MbsClient::waitForEvents(std::vector<MbsClient::MbsEventRecord> &dest, size_t minCount, size_t maxCount,
+                                std::chrono::microseconds timeout)
+{
+    waitForEventsInBuffer(minCount, true, timeout);
+    return getEventRecords(dest, maxCount);
+}
+
+bool MbsClient::waitForBufferSpace(size_t eventBytes)
+{
+    auto hasSpace = [this, eventBytes]()
+    {
+        size_t bytes = bytesInBuffer.load();
+        return eventBuffer.size() < eventBuffer.capacity() && subeventsInBuffer.load() < subeventLimit.load()
+                && (bytes == 0 || bytes + eventBytes <= maxBytesInBuffer.load());
+    };
+
+    if(hasSpace())
+        return !disconnected;
+
+    auto stallBegin = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(spaceMutex);
+        parkedEventBytes.store(eventBytes, std::memory_order_relaxed);
+        // pairs with the fence in notifyReceiver(...)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // the buffer will not grow anymore, a consumer waiting for more events has to take them now
+        notifyEventWaiters(true);
+        spaceAvailable.wait(lock, [this, eventBytes]() { return disconnected || receiverCanResume(eventBytes); });
+        parkedEventBytes.store(noParkedEvent, std::memory_order_relaxed);
+    }
+    receiverStallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - stallBegin).count();
+
+    return !disconnected;
+}
+
+bool MbsClient::receiverCanResume(size_t eventBytes) const
+{
+    if(eventBuffer.size() >= eventBuffer.capacity() || subeventsInBuffer.load() >= subeventLimit.load())
+        return false;
+
+    size_t bytes = bytesInBuffer.load();
+    return bytes == 0 || (bytes <= lowWatermarkBytes.load() && bytes + eventBytes <= maxBytesInBuffer.load());
+}
+
+bool MbsClient::popRecord(MbsEventRecord &record, size_t &bytes)
+{
+    if(eventBuffer.pop(&record, 1) == 0)
+        return false;
+
+    bytes += record.bytes();
+    return true;
+}
+
+void MbsClient::releaseBufferSpace(size_t bytes, size_t subevents)
+{
+    if(bytes == 0 && subevents == 0)
+        return;
+
+    bytesInBuffer -= bytes;
+    subeventsInBuffer -= subevents;
+    notifyReceiver(false);
+}
+
+size_t MbsClient::countSubevents(const MbsEventRecord &record, size_t first)
+{
+    size_t n = 0;
+    for(size_t i = first; i < record.size(); i++)
+        if(record[i].length > 0)
+            n++;
+    return n;
+}
+
+void MbsClient::notifyReceiver(bool force)
+{
+    // pairs with the fence in waitForBufferSpace(...):
+    // either the receiver sees the free space or the consumer sees the parked receiver
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t eventBytes = parkedEventBytes.load(std::memory_order_relaxed);
+    if(eventBytes == noParkedEvent || (!force && !receiverCanResume(eventBytes)))
+        return;
+
+    std::lock_guard<std::mutex> lock(spaceMutex);
+    spaceAvailable.notify_one();
+}
+
+void MbsClient::clearEventBuffer()
+{
+    size_t subevents = countSubevents(partialRecord.record, partialRecord.next);
+    partialRecord = RecordCursor();
+
+    size_t bytes = 0;
+    MbsEventRecord record;
+    while(popRecord(record, bytes))
+        subevents += countSubevents(record);
+    releaseBufferSpace(bytes, subevents);
+}
+
+template<typename PopRecord, typename Sink>
+size_t MbsClient::takeSubevents(RecordCursor &cursor, size_t n, PopRecord &&popRecord, Sink &&sink)
+{
+    // empty subevents are only delivered as part of a record
+    auto skipEmpty = [&cursor]()
+    {
+        while(cursor.next < cursor.record.size() && cursor.record[cursor.next].length == 0)
+            cursor.next++;
+        return cursor.next < cursor.record.size();
+    };
+
+    size_t nTaken = 0;
+    while(nTaken < n)
+    {
+        if(!skipEmpty())
+        {
+            cursor = RecordCursor();
+            if(!popRecord(cursor.record))
+                break;
+            continue;
+        }
+
+        sink(cursor.record, cursor.next);
+        cursor.next++;
+        nTaken++;
+    }
+
+    // do not hold a record without subevents left
+    if(!skipEmpty())
+        cursor = RecordCursor();
+
+    return nTaken;
+}
+
+void MbsClient::getEventData(std::vector<MbsClient::MbsEvent> &dest, size_t nElementsToCopy)
+{
+    size_t bytes = 0;
+    size_t n = takeSubevents(partialRecord, nElementsToCopy,
+                             [this, &bytes](MbsEventRecord& record) { return popRecord(record, bytes); },
+                             [this, &dest](const MbsEventRecord& record, size_t i)
+    {
+        const uint32_t* data = record.data(record[i]);
+        std::vector<uint32_t> payload = payloadPool.acquire(record[i].length);
+        payload.assign(data, data + record[i].length);
+        dest.push_back(MbsEvent{record.timestamp(), std::move(payload)});
+    });
+    releaseBufferSpace(bytes, n);
+}
+
+void MbsClient::getEventViews(std::vector<MbsClient::MbsEventView> &dest, size_t nElementsToMove)
+{
+    size_t bytes = 0;
+    size_t n = takeSubevents(partialRecord, nElementsToMove,
+                             [this, &bytes](MbsEventRecord& record) { return popRecord(record, bytes); },
+                             [&dest](const MbsEventRecord& record, size_t i) { dest.push_back(record.view(i)); });
+    releaseBufferSpace(bytes, n);
+}
+
+size_t MbsClient::getEventRecords(std::vector<MbsClient::MbsEventRecord> &dest, size_t nEvents)
+{
+    size_t oldSize = dest.size();
+    eventBuffer.pop(std::back_inserter(dest), nEvents);
+
+    size_t bytes = 0;
+    size_t subevents = 0;
+    for(size_t i = oldSize; i < dest.size(); i++)
+    {
+        bytes += dest[i].bytes();
+        subevents += countSubevents(dest[i]);
+    }
+    releaseBufferSpace(bytes, subevents);
+
+    return dest.size() - oldSize;
+}
+
+size_t MbsClient::getEventBatch(MbsClient::EventBatch &batch, size_t maxEvents)
+{
+    batch.clear();
+
+    size_t bytes = 0;
+    size_t n = takeSubevents(partialRecord, maxEvents,
+                             [this, &bytes](MbsEventRecord& record) { return popRecord(record, bytes); },
+                             [&batch](const MbsEventRecord& record, size_t i) { batch.append(record, i); });
+    releaseBufferSpace(bytes, n);
+
+    return batch.size();
 }
 
 size_t MbsClient::getSizeOfReceivedData() const
@@ -394,7 +2094,7 @@ size_t MbsClient::getNumberOfReceivedEvents() const
 
 size_t MbsClient::getNumberOfEventsInBuffer() const
 {
-    return eventBuffer.size();
+    return subeventsInBuffer;
 }
 
 std::string MbsClient::getEventServerName() const
@@ -404,5 +2104,6 @@ std::string MbsClient::getEventServerName() const
 
 std::vector<std::string> MbsClient::getFilelist() const
 {
+    std::lock_guard<std::mutex> lock(filelistMutex);
     return filelist;
 }
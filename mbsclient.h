@@ -30,7 +30,18 @@
 #include <chrono>
 #include <type_traits>
 #include <filesystem>
+#include <memory>
+#include <cstring>
+#include <functional>
+#include <deque>
+#include <optional>
 
+#include "eventringbuffer.h"
+#include "iobufferpool.h"
+#include "eventbroadcastring.h"
+#include "subeventrange.h"
+#include "payloadpool.h"
+#include "bufferdecoder.h"
 
 extern "C"
 {
@@ -56,14 +67,23 @@ public:
 
     /**
      * @brief The CONNECTION_OPTION enum
+     *          stream: MBS stream server, the client requests each stream of buffers (port 6002).
+     *          file: LMD file.
+     *          automatic: file for names ending in "lmd", otherwise stream.
+     *          transport: MBS transport server, sends every buffer without request (port 6000). Nothing is lost,
+     *          the readout waits for the client. MBS serves one transport client only.
+     *          eventServer: MBS event server, sends a sample of the events to each client (port 6003),
+     *          see setEventSampleRate(...). For monitors, the readout does not wait for them.
+     *          remoteEventServer: remote event server, same protocol as eventServer.
+     *          Events of the event servers have no buffer, their timestamp is 0.
      */
-    enum ConnectionOption {stream=0, file, automatic};
+    enum ConnectionOption {stream=0, file, automatic, transport, eventServer, remoteEventServer};
 
     /**
-     * @brief Establish a connection to a MBS stream server or a LMD-file.
+     * @brief Establish a connection to a MBS server or a LMD-file.
      *
-     * @param mbsSource The host name or IP of a MBS steam server for a stream connection. The name of a LMD file.
-     * @param conOpt Connection option. Can be a stream or file.
+     * @param mbsSource The host name or IP of a MBS server for a server connection. The name of a LMD file.
+     * @param conOpt Connection option, see ConnectionOption.
      * @param poolForNextFile If true, the function will asynchronously seek for next LMD files that have
      *          name structure 'name_number.lmd'.
      * @return true, if the connection is established.
@@ -86,6 +106,34 @@ public:
      */
     bool connect(std::vector<std::string> filelist, bool poolForNextFile);
 
+    /**
+     * @brief Order of the events of several servers in the event buffer.
+     *          arrival: as the events arrive.
+     *          eventNumber: merged by the event number (l_count, with wrap-around), assuming each server sends
+     *          its events in ascending order. Events with the same number follow each other in the order of the servers.
+     *          timestamp: merged by the time of the buffers, like eventNumber.
+     */
+    enum class MergeOrder {arrival=0, eventNumber, timestamp};
+
+    /**
+     * @brief Read several MBS servers at the same time, e.g. the readout nodes of one experiment.
+     *          Each server is read by its own thread, the events of all servers go into the one event buffer
+     *          (or the batch handler, the subscriptions). MbsEventRecord::source() tells the server of an event.
+     *
+     * @param servers Host names or IPs, optionally with the port: "host:port".
+     * @param conOpt Connection option, the same for all servers. Not file (automatic is taken as stream).
+     * @param order Order of the events of different servers.
+     * @param reorderWindow Number of events held back for the merge. If a server has sent no event for the moment,
+     *          the others are held back until reorderWindow events are waiting, then the smallest is taken anyway.
+     *          Not used for arrival.
+     * @return true, if all servers are connected.
+     *
+     * @example mbsclient.connect({"r4l-21", "r4l-22", "r4l-23", "r4l-24"}, MbsClient::ConnectionOption::stream,
+     *                            MbsClient::MergeOrder::eventNumber);
+     */
+    bool connect(const std::vector<std::string>& servers, ConnectionOption conOpt, MergeOrder order,
+                 size_t reorderWindow = 4096);
+
     /**
      * @brief Close the connection to the MBS stream server or close the current LMD file.
      *
@@ -103,24 +151,174 @@ public:
      * @brief Return readout status.
      * @return true, if there are no more events.
      */
-    bool readoutDone() const { return isConnected() ? noMoreEvents : true; }
+    bool readoutDone() const { return isConnected() ? (noMoreEvents && batchesInFlight == 0) : true; }
 
     /**
      * @brief Set a limit for the internal data buffer to avoid high RAM usage.
      *          The client will wait with reading the LMD files
      *          until the data from internal buffer was copied by getEventData(...).
+     *          The limit counts the subevents getEventData(...) returns, like getEventsInBuffer().
+     *          It takes effect with the next connect(...).
      * @param maxEventBufferSize
      */
     void setBufferLimit(size_t maxEventBufferSize);
 
     /**
-     * @brief Give the number of the MBS events stored in the event buffer.
+     * @brief Set a limit for the event records in the internal data buffer in bytes.
+     *          The size of a record includes its header and subevent table.
+     *          The receiver stops reading when the next event would exceed the limit
+     *          and continues after the consumer has drained the buffer below the low watermark.
+     *          A single event larger than the limit is accepted, if the buffer is empty.
+     *          Takes effect immediately.
+     * @param maxBytes The limit in bytes. Default: 512 MiB.
+     * @param lowWatermark The level in bytes to continue reading at. 0: 3/4 of maxBytes.
+     */
+    void setMemoryLimit(size_t maxBytes, size_t lowWatermark = 0);
+
+    /**
+     * @brief How LMD files are read.
+     *          mapped: memory mapping of the whole file, the kernel reads ahead.
+     *          blocks: read() in blocks, a background thread reads the next blocks.
+     *          ioUring: like blocks, but the reads of all blocks ahead are in flight at the same time.
+     *          Falls back to blocks, if io_uring is not available (Linux before 5.1, seccomp filter).
+     */
+    enum class FileReadMode {mapped=0, blocks, ioUring};
+
+    /**
+     * @brief Set how LMD files are read. Takes effect with the next file.
+     * @param mode Default: mapped.
+     */
+    void setFileReadMode(FileReadMode mode);
+
+    /**
+     * @brief Set the size of the blocks LMD files are read in. A block holds several MBS buffers.
+     *          Takes effect with the next file.
+     * @param bytes The block size, rounded down to whole MBS buffers. 0: one buffer per read. Default: 8 MiB.
+     * @param readAheadBlocks Number of blocks read ahead while the current one is decoded. 0: none. Default: 4.
+     *          Not used for memory mapped files.
+     */
+    void setFileBlockSize(size_t bytes, size_t readAheadBlocks = 4);
+
+    /**
+     * @brief Set the number of threads that decode LMD files besides the receiverThread.
+     *          The receiverThread reads the file in blocks (see setFileBlockSize(...)), the threads swap the blocks
+     *          and split them into events, and the receiverThread completes the events spanned over two blocks
+     *          and puts all events into the event buffer in the order of the file, as without the threads.
+     *          Files in the newer LMD format and servers are always decoded by the receiverThread.
+     *          Can't be changed while connected.
+     * @param nThreads 0: the receiverThread decodes (default).
+     */
+    void setDecodeThreads(size_t nThreads);
+
+    /**
+     * @brief Follow LMD files that MBS is still writing, e.g. for an analysis close to online.
+     *          At the end of a file the receiverThread keeps the position and waits until the file grows
+     *          (inotify, every 100 ms without it), a buffer or an event that is written only partly is read
+     *          again later. The next file is opened once MBS has closed the current one, i.e. when the
+     *          close is reported or the next file appears. With poolForNextFile the next file is taken
+     *          as soon as it is created. Takes effect with the next connect(...).
+     * @param follow Default: false.
+     */
+    void setFileFollow(bool follow);
+
+    /**
+     * @brief Set the number of GETEVT requests to a stream server that are outstanding while a stream is decoded.
+     *          The server sends the next streams while the receiverThread decodes the current one, the rate is
+     *          limited by the network instead of one round trip per stream. Takes effect with the next connect(...).
+     * @param depth 0: the next stream is requested after the current one is decoded, e.g. 2 keeps the
+     *          connection busy. Default: 0.
+     */
+    void setStreamRequestDepth(size_t depth);
+
+    /**
+     * @brief Set the sample rate requested from an event server: it sends only every n-th event.
+     *          Takes effect with the next connect(...).
+     * @param n Default: 1, i.e. all events the server can send.
+     */
+    void setEventSampleRate(size_t n);
+
+    /**
+     * @brief Socket options of the connections to MBS servers. 0, false or unset keeps the kernel default.
+     */
+    struct SocketOptions
+    {
+        size_t receiveBuffer = 0;   // SO_RCVBUF in bytes, e.g. 16 MiB for 100 MB/s over 10 GbE. Set before connecting,
+                                    // the TCP window can grow to it
+        std::optional<bool> noDelay; // TCP_NODELAY. Unset: only streams with setStreamRequestDepth(...) > 0 use it
+        int busyPoll = 0;           // SO_BUSY_POLL in microseconds, may need CAP_NET_ADMIN
+        bool quickAck = false;      // TCP_QUICKACK, set again while reading
+        std::optional<int> keepAlive; // SO_KEEPALIVE: probe a silent connection every keepAlive seconds, 0: off.
+                                    // Unset: 10 s with setAutoReconnect(true), else off
+        int readTimeout = 0;        // in seconds: a server that sends no events for that long has ended
+        int connectTimeout = 0;     // in seconds
+    };
+
+    /**
+     * @brief Set the socket options of the connections to stream, transport and event servers.
+     *          The values in effect are logged once a connection is up. Takes effect with the next connect(...).
+     * @param options Default: SocketOptions().
+     */
+    void setSocketOptions(const SocketOptions& options);
+
+    /**
+     * @brief Open a server again when its connection ends, e.g. when MBS is restarted: a read error, a closed
+     *          connection or the shutdown notice of a stream or transport server. The attempts wait initialBackoff,
+     *          then twice as long each time up to maxBackoff. The event buffer, the counters and the subscriptions
+     *          stay as they are, the consumers only see a gap in the events. A server that is gone without closing
+     *          the connection is noticed with SocketOptions::keepAlive, which is on by default with reconnect, or with
+     *          SocketOptions::readTimeout. Each attempt is limited by SocketOptions::connectTimeout. Without reconnect,
+     *          the readout ends with the connection. Takes effect with the next connection that ends, the keepalive
+     *          default with the next connect(...).
+     * @param on Default: false.
+     */
+    void setAutoReconnect(bool on, std::chrono::milliseconds initialBackoff = std::chrono::milliseconds(100),
+                          std::chrono::milliseconds maxBackoff = std::chrono::seconds(10));
+
+    /**
+     * @brief Return the number of reconnects to a server since connect(...), see setAutoReconnect(...).
+     */
+    size_t getReconnectCount() const { return nReconnects; }
+
+    /**
+     * @brief Return the time connections were down before they were open again, since connect(...).
+     *          Several servers of connect(servers, ...) can be down at the same time, their times are added.
+     * @return The time in seconds.
+     */
+    double getReconnectDowntime() const { return reconnectDowntime.load()*1e-9; }
+
+    /**
+     * @brief Return true while the connection to a server is down and being opened again.
+     */
+    bool isReconnecting() const { return connectionsDown > 0; }
+
+    /**
+     * @brief Return the size of the event data stored in the event buffer.
+     * @return The size in bytes.
+     */
+    size_t getBytesInBuffer() const { return bytesInBuffer; }
+
+    /**
+     * @brief Return the maximal size of the event data in the event buffer since connect(...).
+     * @return The size in bytes.
+     */
+    size_t getBytesInBufferHighWaterMark() const { return bytesInBufferHighWaterMark; }
+
+    /**
+     * @brief Return the time the receiver has waited for the consumer since connect(...),
+     *          because the buffer limit or the memory limit was reached.
+     * @return The time in seconds.
+     */
+    double getReceiverStallTime() const { return receiverStallTime.load()*1e-9; }
+
+    /**
+     * @brief Give the number of the MBS events stored in the event buffer, counted like getEventData(...) returns them:
+     *          one per non-empty subevent.
      * @return The number of MBS events stored in the event buffer.
      */
-    size_t getEventsInBuffer() const { return eventBuffer.size();}
+    size_t getEventsInBuffer() const { return subeventsInBuffer;}
 
     /**
-     * @brief Clear the MBS event data list.
+     * @brief Clear the MBS event data list. Must be called from the thread that calls getEventData(...).
      */
     void clearEventBuffer();
 
@@ -164,13 +362,437 @@ public:
     };
 
     /**
-     * @brief Copy the received MBS data from the eventBuffer to the dest-vector.
+     * @brief Read-only view of the data of one subevent. Points directly into the record of its event.
+     *          The record memory is reused by the client only after all views into it are released.
+     */
+    struct MbsEventView
+    {
+        uint64_t timestamp = 0;         // unix time in milliseconds (sometimes the same between events...)
+        const uint32_t* data = nullptr; // raw data
+        size_t size = 0;                // number of 32 bit words
+        std::shared_ptr<const void> buffer; // keeps the event record alive
+
+        // subevent header
+        int16_t type = 0;
+        int16_t subtype = 0;
+        int16_t procid = 0;
+        uint8_t subcrate = 0;
+        uint8_t control = 0;
+
+        const uint32_t* begin() const { return data; }
+        const uint32_t* end() const { return data + size; }
+        uint32_t operator[](size_t i) const { return data[i]; }
+    };
+
+    /**
+     * @brief Description of one subevent inside a MbsEventRecord.
+     */
+    struct SubeventDescriptor
+    {
+        uint32_t offset;    // index of the first data word in the payload of the record
+        uint32_t length;    // number of data words, can be 0
+        int16_t type;
+        int16_t subtype;
+        int16_t procid;
+        uint8_t subcrate;
+        uint8_t control;
+    };
+
+    /**
+     * @brief A complete MBS event: event header, subevent descriptor table and payload.
+     *          All three are stored in one contiguous, reference counted memory block:
+     *          [Header][SubeventDescriptor * nSubevents][uint32_t * nWords].
+     *          Copies of a record share the block.
+     */
+    class MbsEventRecord
+    {
+    public:
+        struct Header
+        {
+            uint64_t timestamp;     // unix time in milliseconds
+            uint64_t bytes;         // size of the whole block
+            uint32_t count;         // current event number (l_count)
+            uint32_t nSubevents;
+            uint32_t nWords;        // payload size in 32 bit words
+            int16_t type;
+            int16_t subtype;
+            int16_t trigger;
+            int16_t source;         // index of the server in connect(servers, ...), otherwise 0
+        };
+
+        MbsEventRecord() = default;
+        explicit MbsEventRecord(std::shared_ptr<const Header> block) : header(std::move(block)) {}
+
+        /**
+         * @brief Return the size of a block for a record with nSubevents and nWords of payload.
+         */
+        static size_t blockSize(uint32_t nSubevents, uint32_t nWords)
+        {
+            return sizeof(Header) + nSubevents*sizeof(SubeventDescriptor) + nWords*sizeof(uint32_t);
+        }
+
+        explicit operator bool() const { return header != nullptr; }
+
+        uint64_t timestamp() const { return header->timestamp; }
+        uint32_t count() const { return header->count; }
+        int16_t type() const { return header->type; }
+        int16_t subtype() const { return header->subtype; }
+        int16_t trigger() const { return header->trigger; }
+        int16_t source() const { return header->source; }
+        size_t bytes() const { return header ? header->bytes : 0; }
+
+        size_t size() const { return header ? header->nSubevents : 0; }
+        const SubeventDescriptor* begin() const { return reinterpret_cast<const SubeventDescriptor*>(header.get() + 1); }
+        const SubeventDescriptor* end() const { return begin() + size(); }
+        const SubeventDescriptor& operator[](size_t i) const { return begin()[i]; }
+
+        const uint32_t* payload() const { return reinterpret_cast<const uint32_t*>(end()); }
+        size_t payloadSize() const { return header->nWords; }
+        const uint32_t* data(const SubeventDescriptor& subevent) const { return payload() + subevent.offset; }
+
+        /**
+         * @brief Return the first subevent with the processor id, nullptr if there is none.
+         */
+        const SubeventDescriptor* findProcid(int16_t procid) const
+        {
+            for(const SubeventDescriptor& subevent : *this)
+                if(subevent.procid == procid)
+                    return &subevent;
+            return nullptr;
+        }
+
+        /**
+         * @brief Return a view of the i-th subevent that shares the block of the record.
+         */
+        MbsEventView view(size_t i) const
+        {
+            const SubeventDescriptor& subevent = (*this)[i];
+            MbsEventView v;
+            v.timestamp = timestamp();
+            v.data = data(subevent);
+            v.size = subevent.length;
+            v.buffer = header;
+            v.type = subevent.type;
+            v.subtype = subevent.subtype;
+            v.procid = subevent.procid;
+            v.subcrate = subevent.subcrate;
+            v.control = subevent.control;
+            return v;
+        }
+
+    private:
+        std::shared_ptr<const Header> header;
+    };
+
+    /**
+     * @brief Column-wise storage of a set of MBS events. The payload of all events is stored in one array.
+     *          The storage is kept by clear(), so a reused batch does not allocate memory in the steady state.
+     */
+    struct EventBatch
+    {
+        std::vector<uint32_t> words;        // raw data of all events, one after the other
+        std::vector<size_t> offsets{0};     // event i is words[offsets[i]] ... words[offsets[i+1]-1]
+        std::vector<uint64_t> timestamps;   // unix time in milliseconds
+        std::vector<int16_t> types;         // subevent header
+        std::vector<int16_t> subtypes;
+        std::vector<int16_t> procids;
+        std::vector<uint8_t> subcrates;
+
+        size_t size() const { return timestamps.size(); }
+        bool empty() const { return timestamps.empty(); }
+
+        const uint32_t* data(size_t i) const { return words.data() + offsets[i]; }
+        size_t length(size_t i) const { return offsets[i+1] - offsets[i]; }
+
+        void append(const MbsEventView& event)
+        {
+            words.insert(words.end(), event.begin(), event.end());
+            offsets.push_back(words.size());
+            timestamps.push_back(event.timestamp);
+            types.push_back(event.type);
+            subtypes.push_back(event.subtype);
+            procids.push_back(event.procid);
+            subcrates.push_back(event.subcrate);
+        }
+
+        /**
+         * @brief Append the i-th subevent of the record.
+         */
+        void append(const MbsEventRecord& record, size_t i)
+        {
+            const SubeventDescriptor& subevent = record[i];
+            const uint32_t* data = record.data(subevent);
+            words.insert(words.end(), data, data + subevent.length);
+            offsets.push_back(words.size());
+            timestamps.push_back(record.timestamp());
+            types.push_back(subevent.type);
+            subtypes.push_back(subevent.subtype);
+            procids.push_back(subevent.procid);
+            subcrates.push_back(subevent.subcrate);
+        }
+
+        /**
+         * @brief Append the non-empty subevents of the record.
+         */
+        void append(const MbsEventRecord& record)
+        {
+            for(size_t i = 0; i < record.size(); i++)
+                if(record[i].length > 0)
+                    append(record, i);
+        }
+
+        void clear()
+        {
+            words.clear();
+            offsets.assign(1, 0);
+            timestamps.clear();
+            types.clear();
+            subtypes.clear();
+            procids.clear();
+            subcrates.clear();
+        }
+    };
+
+    /**
+     * @brief Copy the received MBS data from the eventBuffer to the dest-vector. One element per non-empty subevent.
+     *          The event buffer is a single-consumer queue: call this function from one thread only.
      *
      * @param dest The destination vector for the event data.
      * @param NumOfElementsToCopy The number of elements have to be copied from eventBuffer to the dest-vector.
      */
     void getEventData(std::vector<MbsClient::MbsEvent>& dest, size_t nElementsToCopy);
 
+    /**
+     * @brief Hand the events from getEventData(...) back to the client, which reuses their data vectors.
+     *          Can be called from any thread. The events vector is cleared.
+     *
+     * @example
+     *  client.getEventData(events, 1000);
+     *  process(events);
+     *  client.recycle(events);
+     */
+    void recycle(std::vector<MbsClient::MbsEvent>& events) { payloadPool.release(events); }
+
+    /**
+     * @brief Return how often getEventData(...) got a data vector from the recycled ones
+     *          and how often it had to allocate one. Without misses the steady state is allocation-free.
+     */
+    size_t getPayloadPoolHits() const { return payloadPool.getHits(); }
+    size_t getPayloadPoolMisses() const { return payloadPool.getMisses(); }
+
+    /**
+     * @brief Move the received MBS data from the eventBuffer to the dest-vector without copying the data.
+     *          One element per non-empty subevent. Hold the views only as long as needed,
+     *          the record memory is not reused before.
+     *          The event buffer is a single-consumer queue: call this function from one thread only.
+     *
+     * @param dest The destination vector for the event views.
+     * @param nElementsToMove The number of elements have to be moved from eventBuffer to the dest-vector.
+     */
+    void getEventViews(std::vector<MbsClient::MbsEventView>& dest, size_t nElementsToMove);
+
+    /**
+     * @brief Move complete MBS events from the eventBuffer to the dest-vector, also events without data.
+     *          Do not mix with the subevent functions above in the middle of an event.
+     *          The event buffer is a single-consumer queue: call this function from one thread only.
+     *
+     * @param dest The destination vector for the events.
+     * @param nEvents The maximal number of events.
+     * @return The number of moved events.
+     */
+    size_t getEventRecords(std::vector<MbsClient::MbsEventRecord>& dest, size_t nEvents);
+
+    /**
+     * @brief Replace the content of the batch by up to maxEvents non-empty subevents from the eventBuffer.
+     *          The event buffer is a single-consumer queue: call this function from one thread only.
+     *
+     * @param batch The destination batch. Reuse it between the calls.
+     * @param maxEvents The maximal number of events.
+     * @return The number of events in the batch.
+     */
+    size_t getEventBatch(MbsClient::EventBatch& batch, size_t maxEvents);
+
+    /**
+     * @brief Process the events on a pool of worker threads instead of the event buffer.
+     *          The receiver packs the events into batches and hands them directly to the workers.
+     *          getEventData(...) and the other pull functions get no events in this mode.
+     *          A batch is dispatched, when it is full or when the source has no data for the moment.
+     *          Must be called before connect(...).
+     *
+     * @param handler Called by the worker threads for each batch. Called concurrently, if nThreads > 1.
+     *          The batch is reused after the handler has returned. An empty function disables the handlers.
+     * @param nThreads The number of worker threads.
+     * @param maxBatchEvents The maximal number of events in a batch.
+     *
+     * @example mbsclient.setBatchHandler([&](const MbsClient::EventBatch& batch){ fillHistograms(batch); }, 4);
+     *          mbsclient.connect("run_0001.lmd", MbsClient::ConnectionOption::file, false);
+     */
+    void setBatchHandler(std::function<void(const EventBatch&)> handler, size_t nThreads,
+                         size_t maxBatchEvents = 4096);
+
+    /**
+     * @brief Policy of a subscription.
+     *          lossless: the receiver waits for the subscriber, if its events are not read yet.
+     *          dropOldest: the receiver never waits, the subscriber loses the oldest events instead. For monitors.
+     */
+    enum class SubscriberPolicy {lossless=0, dropOldest};
+
+private:
+    struct Broadcast;   // state shared by the client and the subscriptions
+
+    // a record and the index of the next subevent to take from it
+    struct RecordCursor
+    {
+        MbsEventRecord record;
+        size_t next = 0;
+    };
+
+    /**
+     * @brief Pass up to n non-empty subevents to sink(record, index). Continues with the record in cursor,
+     *          then takes records from popRecord(record) until it returns false.
+     * @return The number of subevents.
+     */
+    template<typename PopRecord, typename Sink>
+    static size_t takeSubevents(RecordCursor& cursor, size_t n, PopRecord&& popRecord, Sink&& sink);
+
+public:
+    /**
+     * @brief An independent reader of the events received by one MbsClient.
+     *          Each subscription reads all events with its own position in a shared ring.
+     *          One thread per subscription may read from it.
+     */
+    class Subscription
+    {
+    public:
+        ~Subscription();
+
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        /**
+         * @brief Move up to n events to the dest-vector without copying the data.
+         * @return The number of events.
+         */
+        size_t getEventViews(std::vector<MbsClient::MbsEventView>& dest, size_t n);
+
+        /**
+         * @brief Copy up to nEvents complete MBS events to the dest-vector. The records share the memory.
+         * @return The number of events.
+         */
+        size_t getEventRecords(std::vector<MbsClient::MbsEventRecord>& dest, size_t nEvents);
+
+        /**
+         * @brief Copy up to n events to the dest-vector.
+         * @return The number of events.
+         */
+        size_t getEventData(std::vector<MbsClient::MbsEvent>& dest, size_t n);
+
+        /**
+         * @brief Return the data vectors of events from getEventData(...) for reuse. Thread safe.
+         */
+        void recycle(std::vector<MbsClient::MbsEvent>& events) { payloadPool.release(events); }
+
+        /**
+         * @brief Replace the content of the batch by up to maxEvents events.
+         * @return The number of events in the batch.
+         */
+        size_t getEventBatch(MbsClient::EventBatch& batch, size_t maxEvents);
+
+        /**
+         * @brief Wait until at least minCount events can be read. Returns earlier,
+         *          if the timeout expires, the readout of the client is done
+         *          or a lossless subscription holds up the client with a full ring.
+         * @param minCount The number of events, counted like getEventsInBuffer().
+         * @return true, if minCount events can be read.
+         */
+        bool waitForEvents(size_t minCount, std::chrono::microseconds timeout);
+
+        /**
+         * @brief Return the number of events that can be read, counted like getEventData(...) returns them:
+         *          one per non-empty subevent.
+         */
+        size_t getEventsInBuffer() const;
+
+        /**
+         * @brief Return the number of events lost by this subscription (dropOldest only).
+         */
+        uint64_t getDroppedEvents() const { return droppedEvents; }
+
+        SubscriberPolicy getPolicy() const { return policy; }
+
+    private:
+        friend class MbsClient;
+        Subscription(std::shared_ptr<Broadcast> broadcast, SubscriberPolicy policy);
+
+        /**
+         * @brief Copy up to n records from the shared ring to the output iterator.
+         */
+        template<typename OutputIt>
+        size_t readRecords(OutputIt out, size_t n);
+
+        /**
+         * @brief Return the number of non-empty subevents that can be read.
+         * @param published Set to the publishedSubevents the result refers to.
+         */
+        uint64_t availableSubevents(uint64_t& published) const;
+
+        std::shared_ptr<Broadcast> broadcast;
+        const SubscriberPolicy policy;
+        std::atomic<uint64_t> cursor{0};    // sequence number of the next event to read
+        std::atomic<uint64_t> droppedEvents{0};
+        RecordCursor partialRecord;         // record with subevents not taken yet
+        PayloadPool payloadPool;            // data vectors for getEventData(...)
+    };
+
+    /**
+     * @brief Add a subscriber. With at least one subscription at connect(...), the client distributes all events
+     *          to the subscriptions instead of the event buffer. One connection to the MBS server serves them all.
+     *          The slowest lossless subscription limits the receiver, dropOldest ones never slow down the others.
+     *          The shared ring has the size set by setBufferLimit(...), the memory limit is not used.
+     *          A subscription ends when the returned pointer is released.
+     *
+     * @param policy lossless or dropOldest.
+     * @return The subscription.
+     *
+     * @example auto monitor = mbsclient.subscribe(MbsClient::SubscriberPolicy::dropOldest);
+     *          auto writer = mbsclient.subscribe(MbsClient::SubscriberPolicy::lossless);
+     *          mbsclient.connect("r4l-21", MbsClient::ConnectionOption::stream, false);
+     */
+    std::shared_ptr<Subscription> subscribe(SubscriberPolicy policy);
+
+    /**
+     * @brief Wait until at least minCount events are in the event buffer, then copy up to maxCount events
+     *          to the dest-vector. Returns earlier, if the timeout expires, the readout is done
+     *          or the receiver waits for space in the event buffer.
+     *          Call this function from the thread that calls getEventData(...).
+     *
+     * @param dest The destination vector for the event data.
+     * @param minCount The number of events to wait for, counted like getEventsInBuffer(): one per non-empty subevent.
+     *          Limited by the buffer limit.
+     * @param maxCount The maximal number of events to copy.
+     * @param timeout The maximal waiting time.
+     * @return The number of copied events. Can be smaller than minCount, also zero.
+     *
+     * @example std::vector<MbsClient::MbsEvent> events;
+     *          while(!mbsclient.readoutDone())
+     *              mbsclient.waitForEvents(events, 100, 10000, std::chrono::milliseconds(500));
+     */
+    size_t waitForEvents(std::vector<MbsClient::MbsEvent>& dest, size_t minCount, size_t maxCount,
+                         std::chrono::microseconds timeout);
+
+    /**
+     * @brief Same as waitForEvents(...) above, but moves the event views like getEventViews(...).
+     */
+    size_t waitForEvents(std::vector<MbsClient::MbsEventView>& dest, size_t minCount, size_t maxCount,
+                         std::chrono::microseconds timeout);
+
+    /**
+     * @brief Same as waitForEvents(...) above, but moves complete events like getEventRecords(...).
+     *          minCount counts complete events here, not subevents.
+     */
+    size_t waitForEvents(std::vector<MbsClient::MbsEventRecord>& dest, size_t minCount, size_t maxCount,
+                         std::chrono::microseconds timeout);
+
 private:
 
     /**
@@ -181,39 +803,472 @@ private:
     /**
      * @brief Open a single LMD File or a connection to a MBS server.
      * @param mbsSource Filename.
-     * @param sourceType GETEVT__FILE/GETEVT__STREAM
+     * @param sourceType GETEVT__FILE/GETEVT__STREAM/GETEVT__TRANS/GETEVT__EVENT/GETEVT__REVSERV
      * @return true, if successful
      */
     bool openLmdFile(std::string mbsSource, INTS4 sourceType);
 
+    /**
+     * @brief Apply the settings of the client to a new input channel before it is opened.
+     */
+    void configureChannel(s_evt_channel *channel, INTS4 sourceType);
+
+    /**
+     * @brief The server type of f_evt_get_open(...) for a connection option other than file and automatic.
+     * @return GETEVT__STREAM/GETEVT__TRANS/GETEVT__EVENT/GETEVT__REVSERV, 0 for file and automatic.
+     */
+    static INTS4 serverType(ConnectionOption conOpt);
+
+    /**
+     * @brief Print the socket options in effect for the connection of a channel to a server.
+     */
+    static void logSocketOptions(const s_evt_channel *channel, const std::string& name);
+
+    /**
+     * @brief Open a stream, transport or event server ("host" or "host:port") for connect(servers, ...) or a reconnect.
+     * @return The open channel, nullptr on failure.
+     */
+    s_evt_channel* openServer(const std::string& server, INTS4 sourceType);
+
+    /**
+     * @brief Close a server connection that has ended and open it again, see setAutoReconnect(...).
+     *          Waits with exponential backoff between the attempts.
+     * @param channel The channel of the connection, replaced by the new one (nullptr while there is none).
+     * @param socket The socket disconnect() shuts down to wake the reader, guarded by connectionMutex.
+     * @return true, if the server is connected again. false, if disconnect() was called meanwhile.
+     */
+    bool reconnectServer(s_evt_channel*& channel, int& socket, const std::string& server, INTS4 sourceType);
+
+    /**
+     * @brief Called for each GETEVT__TIMEOUT of a server: an idle server, e.g. an empty stream, or a read timeout.
+     * @param silentSince The first GETEVT__TIMEOUT in a row, reset by the caller when an event arrives.
+     * @return true, if the timeouts in a row last SocketOptions::readTimeout: the server is taken as gone.
+     */
+    bool serverSilent(std::optional<std::chrono::steady_clock::time_point>& silentSince);
+
     /**
      * @brief Seek for a new LMD file. Called by fileseekThread.
+     *
+     * On Linux the directory is watched with inotify: a file name_NNNN.lmd with a higher number
+     * than the last file of the filelist is appended as soon as MBS closes it for writing or moves it
+     * into the directory. Elsewhere, or if the watch can't be added, the next file is looked for every 100 ms.
      */
     void newFileSeeker();
 
-    // buffer for received mbs events
-    std::deque<MbsEvent> eventBuffer;
+    /**
+     * @brief Mark the end of the fileseekThread and wake the receiverThread waiting in takeNextFile(...).
+     */
+    void stopFileSeeker();
+
+    /**
+     * @brief Take the next file of the filelist. Called by the receiverThread.
+     * @param path Set to the next file.
+     * @param wait Wait until the fileseekThread appends a file, stops or the client is disconnected.
+     * @return true, if there is a next file
+     */
+    bool takeNextFile(std::string &path, bool wait);
+
+    /**
+     * @brief Split a file name of the format filename_number.lmd.
+     * @return false, if the name has another format
+     */
+    static bool splitFileNumber(const std::string &filename, std::string &prefix, uint64_t &number);
+
+    /**
+     * @brief Watch a followed file for new data and for the close by MBS. Replaces the watch of the previous file.
+     */
+    void watchFile(const std::string &path);
+
+    /**
+     * @brief Remove the watch of the followed file.
+     */
+    void unwatchFile();
+
+    /**
+     * @brief Wait at the end of a followed file until it grows, at most 100 ms. Called by the receiverThread.
+     * @return false, if MBS has closed the file and its end is read already, or after disconnect()
+     */
+    bool waitForFileData();
+
+    /**
+     * @brief Open a followed file, wait until MBS has written enough to open it.
+     * @return false, if the file was closed without becoming a valid LMD file, or after disconnect()
+     */
+    bool openFollowedFile(const std::string &path);
+
+    /**
+     * @brief Apply the buffer limit set by setBufferLimit(...) to the event ring. Called by connect(...).
+     */
+    void resizeEventBuffer();
+
+    // memory of the event records of one thread.
+    // records are placed one after the other into chunks, a chunk returns to the recordPool after its last record
+    struct RecordArena
+    {
+        std::shared_ptr<char> chunk;
+        size_t used = 0;
+    };
+
+    /**
+     * @brief Copy an event of the MBS API into a new record.
+     *          Called by the receiverThread and the decode workers, each with its own arena.
+     * @param event The event.
+     * @param timestamp The time of the buffer with the event.
+     * @param swapData True, if the subevent data is still in the byte order of the sender.
+     * @param arena The memory of the calling thread.
+     * @param serverIndex The index of the server in connect(servers, ...).
+     * @return The record.
+     */
+    MbsEventRecord makeRecord(const s_ve10_1* event, uint64_t timestamp, bool swapData, RecordArena& arena,
+                              int16_t serverIndex = 0);
+
+    /**
+     * @brief Return memory for a record. Small records share chunks from the recordPool.
+     */
+    std::shared_ptr<char> allocateRecord(size_t bytes, RecordArena& arena);
+
+    /**
+     * @brief Return the time of a buffer in ms, 0 without buffer header.
+     */
+    static uint64_t bufferTimestamp(const s_bufhe* header);
+
+    /**
+     * @brief Count the data of a received event and put it into the event buffer with pushEvent(...).
+     *          Called by the receiverThread.
+     * @return false, if disconnected.
+     */
+    bool commitRecord(MbsEventRecord&& record);
+
+    // a block of an LMD file, decoded by a decode worker
+    struct DecodeJob
+    {
+        char* block = nullptr;          // in the mapping of the file or in buffer
+        std::shared_ptr<char> buffer;   // copy of a block that is not mapped or needs a swap
+        size_t bytes = 0;
+        bool swap = false;              // the block is in the byte order of the sender
+        BufferDecoder decoder;
+        std::vector<MbsEventRecord> records;
+        bool done = false;              // guarded by decodeMutex
+    };
+
+    // one server of connect(servers, ...)
+    struct MergeSource
+    {
+        std::string name;
+        int16_t index = 0;
+        INTS4 type = GETEVT__STREAM;
+        s_evt_channel* channel = nullptr;               // replaced by a reconnect
+        int socket = -1;                                // guarded by connectionMutex, see reconnectServer(...)
+        EventRingBuffer<MbsEventRecord> queue{4096};    // filled by the source thread, emptied by the receiverThread
+        std::atomic_bool finished{false};               // the connection has ended, set after the last push
+        std::thread thread;
+        // only used by the receiverThread
+        std::deque<MbsEventRecord> staged;              // taken from the queue, not committed yet
+        bool drained = false;                           // finished and the queue is empty
+    };
+
+    /**
+     * @brief Main function of the thread that reads one server of connect(servers, ...).
+     */
+    void sourceReceiver(MergeSource& source);
+
+    /**
+     * @brief Wake up the receiverThread waiting for the source threads.
+     */
+    void notifyMerger();
+
+    /**
+     * @brief Return true, if the record a goes into the event buffer before the record b, see MergeOrder.
+     */
+    bool mergesBefore(const MbsEventRecord& a, const MbsEventRecord& b) const;
+
+    /**
+     * @brief Commit the events of the source threads in the merge order. Runs in the receiverThread instead of
+     *          eventReceiver() after connect(servers, ...).
+     */
+    void mergeReceiver();
+
+    /**
+     * @brief Stop the source threads after the receiverThread and close their connections. Called by disconnect().
+     */
+    void stopMergeSources();
+
+    /**
+     * @brief Start the decode workers. Called by connect(...).
+     */
+    void startDecodeWorkers();
+
+    /**
+     * @brief Stop the decode workers after the receiverThread. Called by disconnect().
+     */
+    void stopDecodeWorkers();
+
+    /**
+     * @brief Main function of a decode worker thread.
+     */
+    void decodeWorker();
+
+    /**
+     * @brief Read the current file in blocks, have them decoded by the decode workers
+     *          and commit the events in the order of the file. Called by the receiverThread instead of f_evt_get_event(...).
+     * @param stopped Set if commitRecord(...) refused an event. The receiverThread then ends,
+     *          as it does for a refused event of f_evt_get_event(...).
+     * @return The status of f_evt_get_block(...) that ended the reading, e.g. GETEVT__NOMORE.
+     */
+    INTS4 receiveBlocks(bool &stopped);
+
+    /**
+     * @brief Block until the event buffer holds minCount events, the readout is done or the timeout expires.
+     * @param records If true, count the records in the eventBuffer,
+     *          otherwise the non-empty subevents like getEventsInBuffer().
+     * @return true, if not timed out.
+     */
+    bool waitForEventsInBuffer(size_t minCount, bool records, std::chrono::microseconds timeout);
+
+    /**
+     * @brief Wake up a consumer in waitForEvents(...). Called by the receiverThread and by disconnect().
+     * @param force If false, wake up only if the event buffer holds the requested number of events.
+     */
+    void notifyEventWaiters(bool force);
+
+    /**
+     * @brief Block the receiverThread until an event of eventBytes fits into the event buffer.
+     * @return false, if disconnected.
+     */
+    bool waitForBufferSpace(size_t eventBytes);
+
+    /**
+     * @brief Put an event into the event buffer or, with a batch handler, into the current batch.
+     *          Called by the receiverThread.
+     * @return false, if disconnected.
+     */
+    bool pushEvent(MbsEventRecord&& record);
+
+    // worker thread of the batch handler with its batch queues
+    struct BatchWorker
+    {
+        EventRingBuffer<std::unique_ptr<EventBatch>> pending;   // filled by the receiverThread
+        EventRingBuffer<std::unique_ptr<EventBatch>> done;      // processed batches for reuse
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::atomic_bool idle{false};
+        std::thread thread;
+    };
+
+    /**
+     * @brief Start the batch workers. Called by connect(...).
+     */
+    void startBatchWorkers();
+
+    /**
+     * @brief Process the dispatched batches and stop the batch workers. Called by disconnect().
+     */
+    void stopBatchWorkers();
+
+    /**
+     * @brief Main function of a batch worker thread.
+     */
+    void batchWorker(BatchWorker& worker);
+
+    /**
+     * @brief Hand the current batch to the worker with the fewest pending batches. Called by the receiverThread.
+     */
+    void dispatchBatch();
+
+    /**
+     * @brief Take a processed batch for reuse. Blocks until a worker has returned a batch.
+     * @return The batch, or nullptr if disconnected.
+     */
+    std::unique_ptr<EventBatch> acquireBatch();
+
+    /**
+     * @brief Put an event into the ring of the subscriptions. Called by the receiverThread.
+     * @return false, if disconnected.
+     */
+    bool publishEvent(MbsEventRecord&& record);
+
+    /**
+     * @brief Return the read position of the slowest lossless subscription. Removes ended subscriptions.
+     * @param published Returned if there is no lossless subscription.
+     */
+    uint64_t slowestLosslessCursor(uint64_t published);
+
+    /**
+     * @brief Wake up subscriptions in waitForEvents(...).
+     * @param force If false, wake up only if a subscription can read the requested number of events.
+     */
+    void notifySubscribers(bool force);
+
+    /**
+     * @brief Check if a parked receiverThread can continue with an event of eventBytes.
+     */
+    bool receiverCanResume(size_t eventBytes) const;
+
+    /**
+     * @brief Take one record from the event buffer. Called by the consumer.
+     * @param bytes Incremented by the size of the record.
+     * @return false, if the event buffer is empty.
+     */
+    bool popRecord(MbsEventRecord& record, size_t& bytes);
+
+    /**
+     * @brief Account for records and subevents taken from the event buffer and wake up a parked receiverThread.
+     *          Called by the consumer.
+     */
+    void releaseBufferSpace(size_t bytes, size_t subevents);
+
+    /**
+     * @brief Return the number of non-empty subevents of the record from the subevent first on.
+     */
+    static size_t countSubevents(const MbsEventRecord& record, size_t first = 0);
+
+    /**
+     * @brief Wake up a parked receiverThread.
+     * @param force If false, wake up only if the receiverThread can continue.
+     */
+    void notifyReceiver(bool force);
+
+    // buffer for received mbs events. lock-free, filled by the receiverThread, emptied by getEventData(...)
+    EventRingBuffer<MbsEventRecord> eventBuffer;
+    RecordCursor partialRecord;     // record with subevents not taken yet by the consumer
+    std::atomic<size_t> subeventsInBuffer{0};   // non-empty subevents in eventBuffer and partialRecord
+    std::atomic<size_t> subeventLimit{0};       // maxEventBufferSize of the current connection
+    PayloadPool payloadPool;        // data vectors for getEventData(...), returned by recycle(...)
+
+    // wakeup of a consumer blocked in waitForEvents(...)
+    std::mutex waitMutex;
+    std::condition_variable eventsAvailable;
+    std::atomic<size_t> wakeThreshold{0};   // number of events the consumer waits for, 0: nobody waits
+    std::atomic_bool wakeOnRecords{false};  // the threshold counts records, not subevents
+
+    // backpressure on the receiverThread
+    static constexpr size_t noParkedEvent = SIZE_MAX;
+    std::mutex spaceMutex;
+    std::condition_variable spaceAvailable;
+    std::atomic<size_t> parkedEventBytes{noParkedEvent}; // size of the event the receiver waits to push
+    std::atomic<size_t> maxBytesInBuffer{size_t(512) << 20};
+    std::atomic<size_t> lowWatermarkBytes{size_t(384) << 20};
+    std::atomic<size_t> bytesInBuffer{0};
+    std::atomic<size_t> bytesInBufferHighWaterMark{0};
+    std::atomic<uint64_t> receiverStallTime{0};   // in nanoseconds
+
+    // batch handler
+    static constexpr size_t batchesPerWorker = 4;
+    std::function<void(const EventBatch&)> batchHandler;
+    size_t nBatchThreads = 0;
+    size_t maxBatchEvents = 4096;
+    std::vector<std::unique_ptr<BatchWorker>> batchWorkers;
+    std::unique_ptr<EventBatch> currentBatch;   // filled by the receiverThread
+    std::atomic_bool batchWorkersStop{false};
+    std::atomic<size_t> batchesInFlight{0};    // dispatched, but not processed
+    std::mutex batchMutex;
+    std::condition_variable batchReturned;
+    std::atomic_bool receiverWaitsForBatch{false};
+
+    // subscriptions
+    struct Broadcast
+    {
+        // a record and the number of non-empty subevents published before it
+        struct Entry
+        {
+            MbsEventRecord record;
+            uint64_t subeventsBefore = 0;
+        };
+        EventBroadcastRing<Entry> ring;
+        std::atomic<uint64_t> publishedSubevents{0};    // non-empty subevents of all published records
+
+        std::mutex subscriberMutex;
+        std::vector<std::weak_ptr<Subscription>> subscribers;
+        uint64_t slowestCursor = 0;     // cached by the receiverThread
+
+        // the receiverThread waits for lossless subscriptions
+        std::mutex writerMutex;
+        std::condition_variable writerWakeup;
+        std::atomic_bool writerWaits{false};
+
+        // subscriptions wait for events
+        std::mutex readerMutex;
+        std::condition_variable readerWakeup;
+        std::atomic<uint64_t> wakeSubevents{UINT64_MAX}; // smallest publishedSubevents a subscription waits for
+        std::atomic_bool finished{false};               // no more events or disconnected
+    };
+    std::shared_ptr<Broadcast> broadcast;
+    bool fanOut = false;    // events go to the subscriptions
+
+    // memory of the event records
+    static constexpr size_t recordChunkSize = size_t(1) << 20;
+    IoBufferPool recordPool;
+    RecordArena receiverArena;
+    std::atomic<size_t> nMalformedEvents{0};    // events with a broken subevent since connect(...)
+
+    // decode workers, see setDecodeThreads(...)
+    size_t nDecodeThreads = 0;
+    std::vector<std::thread> decodeWorkers;
+    std::mutex decodeMutex;
+    std::condition_variable decodeWakeup;       // the workers wait for blocks
+    std::condition_variable decodeDone;         // the receiverThread waits for the oldest block
+    std::deque<DecodeJob*> decodeQueue;         // blocks not taken by a worker yet
+    bool decodeStop = false;
+    // only used by the receiverThread
+    std::deque<std::unique_ptr<DecodeJob>> decodeInFlight;  // in the order of the file
+    std::vector<std::unique_ptr<DecodeJob>> decodeFreeJobs;
+    BufferDecoder blockDecoder;     // state of the file behind the last committed block
+    IoBufferPool blockPool;
+    bool decodeBlocks = false;      // the current file is read by receiveBlocks()
+
+    // several servers, see connect(servers, ...)
+    std::vector<std::unique_ptr<MergeSource>> mergeSources;
+    MergeOrder mergeOrder = MergeOrder::arrival;
+    size_t mergeWindow = 1;
+    std::mutex mergeMutex;
+    std::condition_variable mergeWakeup;        // a source thread has pushed events or ended
+    std::atomic_bool mergerWaits{false};
 
     std::vector<std::string> filelist;
     size_t currentFileIndex = 0;
-    bool noMoreEvents = false;
+    std::atomic_bool noMoreEvents{false};
 
     // thread stuff for reading the data
-    std::mutex queueMutex;
     std::atomic_bool disconnected;
     std::vector<std::thread> receiverThread;
 
     // thread stuff for seeking for a new file
-    std::mutex filelistMutex;
+    mutable std::mutex filelistMutex;           // guards filelist, currentFileIndex and seekingFiles
+    std::condition_variable filelistChanged;    // a file was appended or the fileseekThread stopped
+    bool seekingFiles = false;
     std::vector<std::thread> fileseekThread;
 
+    // following a file that is still written, see setFileFollow(...)
+    std::atomic_bool followFiles{false};
+    bool followFile = false;        // the current connection follows its files
+    int followWatch = -1;           // inotify descriptor of the current file, only used by the receiverThread
+    bool followClosed = false;      // MBS has closed the current file
+
     // used by the MBS API
+    std::atomic<size_t> fileBlockSize{size_t(8) << 20};    // may be set while the next file is opened
+    std::atomic<size_t> fileReadAheadBlocks{4};
+    std::atomic<FileReadMode> fileReadMode{FileReadMode::mapped};
+    std::atomic<size_t> streamRequestDepth{0};
+    std::atomic<size_t> eventSampleRate{1};
+    std::mutex socketOptionsMutex;
+    SocketOptions socketOptions;
+
+    // reconnect, see setAutoReconnect(...)
+    std::atomic_bool autoReconnect{false};
+    static constexpr int reconnectKeepAlive = 10;   // in seconds, SocketOptions::keepAlive if unset
+    std::atomic<std::chrono::milliseconds> reconnectBackoff{std::chrono::milliseconds(100)};
+    std::atomic<std::chrono::milliseconds> reconnectBackoffMax{std::chrono::seconds(10)};
+    std::atomic<size_t> nReconnects{0};
+    std::atomic<uint64_t> reconnectDowntime{0};     // in nanoseconds
+    std::atomic<size_t> connectionsDown{0};
+    std::mutex connectionMutex;                     // a socket is not shut down while it is closed
+    int serverSocket = -1;                          // socket of inputChannel to a server, guarded by connectionMutex
+    INTS4 inputType = 0;                            // server type of inputChannel
     s_evt_channel *inputChannel;
     s_filhe *fileHeader;
     s_bufhe *bufferHeader;
 
     std::string mbsSource;
-    std::atomic<size_t> nEventsInBuffer;
     std::atomic<size_t> nReceivedEvents;
     std::atomic<size_t> sizeOfReceivedData;   // in bytes
 
@@ -0,0 +1,160 @@
+/*
+    A C++ client for a GSI MBS stream server.
+    Can also asynchronously open a set of LMD (List Mode) files.
+
+    Copyright (C) 2014-2023 Maxim Singer
+
+    License: GNU GPLv3 (https://www.gnu.org/licenses/gpl-3.0.html)
+
+    Source code: https://github.com/virtmax/MbsClient
+*/
+
+
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+#pragma once
+
+
+/**
+ * @brief Size-classed pool of payload vectors for copied events.
+ *
+ * acquire(...) is called by one thread, the consumer that copies the events.
+ * release(...) may be called by any thread and takes all vectors of a set of events with one lock.
+ * The consumer keeps its own free lists and only takes the released vectors
+ * when a free list is empty, so the consumer does not lock per event.
+ * Class k holds vectors with a capacity of at least 2^k words.
+ */
+class PayloadPool
+{
+public:
+    explicit PayloadPool(size_t maxBytes = size_t(64) << 20) : maxBytes(maxBytes) {}
+
+    PayloadPool(const PayloadPool&) = delete;
+    PayloadPool& operator=(const PayloadPool&) = delete;
+
+    /**
+     * @brief Get an empty vector with a capacity of at least nWords. Called by the consumer.
+     */
+    std::vector<uint32_t> acquire(size_t nWords)
+    {
+        const size_t k = upperClass(nWords);
+        if(k >= nClasses)
+        {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            std::vector<uint32_t> payload;
+            payload.reserve(nWords);
+            return payload;
+        }
+
+        if(freeLists[k].empty())
+            takeReleased();
+
+        // a vector of the next class is still better than an allocation
+        size_t source = k;
+        if(freeLists[source].empty() && source + 1 < nClasses)
+            source++;
+
+        if(freeLists[source].empty())
+        {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            std::vector<uint32_t> payload;
+            // round up, so that the vector returns to the same class
+            payload.reserve(size_t(1) << k);
+            return payload;
+        }
+
+        hits.fetch_add(1, std::memory_order_relaxed);
+        std::vector<uint32_t> payload = std::move(freeLists[source].back());
+        freeLists[source].pop_back();
+        pooledBytes.fetch_sub(payload.capacity()*sizeof(uint32_t), std::memory_order_relaxed);
+        return payload;
+    }
+
+    /**
+     * @brief Take the payload vectors (member data) of the events and clear the events. Thread safe.
+     *          Vectors beyond the size limit of the pool are freed.
+     */
+    template<typename Event>
+    void release(std::vector<Event>& events)
+    {
+        {
+            std::lock_guard<std::mutex> lock(releasedMutex);
+            for(Event& event : events)
+            {
+                std::vector<uint32_t>& payload = event.data;
+                const size_t k = lowerClass(payload.capacity());
+                const size_t bytes = payload.capacity()*sizeof(uint32_t);
+                if(k >= nClasses || pooledBytes.load(std::memory_order_relaxed) + bytes > maxBytes)
+                    continue;
+
+                payload.clear();
+                released[k].push_back(std::move(payload));
+                pooledBytes.fetch_add(bytes, std::memory_order_relaxed);
+            }
+        }
+        events.clear();
+    }
+
+    size_t getHits() const { return hits.load(std::memory_order_relaxed); }
+    size_t getMisses() const { return misses.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t nClasses = 32;
+
+    // smallest k with 2^k >= n
+    static size_t upperClass(size_t n)
+    {
+        size_t k = 0;
+        while((size_t(1) << k) < n)
+            k++;
+        return k;
+    }
+
+    // largest k with 2^k <= n, nClasses for n == 0
+    static size_t lowerClass(size_t n)
+    {
+        if(n == 0)
+            return nClasses;
+
+        size_t k = 0;
+        while((n >> (k + 1)) != 0)
+            k++;
+        return k;
+    }
+
+    void takeReleased()
+    {
+        std::lock_guard<std::mutex> lock(releasedMutex);
+        for(size_t k = 0; k < nClasses; k++)
+        {
+            if(freeLists[k].empty())
+                freeLists[k].swap(released[k]);     // keeps the capacity of both lists
+            else
+            {
+                for(auto& payload : released[k])
+                    freeLists[k].push_back(std::move(payload));
+                released[k].clear();
+            }
+        }
+    }
+
+    const size_t maxBytes;
+    std::atomic<size_t> pooledBytes{0};
+
+    // consumer owned
+    std::array<std::vector<std::vector<uint32_t>>, nClasses> freeLists;
+
+    std::mutex releasedMutex;
+    std::array<std::vector<std::vector<uint32_t>>, nClasses> released;
+
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+};
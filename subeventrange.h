@@ -0,0 +1,179 @@
+/*
+    A C++ client for a GSI MBS stream server.
+    Can also asynchronously open a set of LMD (List Mode) files.
+
+    Copyright (C) 2014-2023 Maxim Singer
+
+    License: GNU GPLv3 (https://www.gnu.org/licenses/gpl-3.0.html)
+
+    Source code: https://github.com/virtmax/MbsClient
+*/
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+extern "C"
+{
+#include "s_ve10_1_swap.h"
+#include "s_ves10_1.h"
+#include "f_ut_swap4.h"
+}
+
+
+#pragma once
+
+
+/**
+ * @brief One subevent of a raw MBS event.
+ */
+struct MbsSubevent
+{
+    const s_ves10_1* header = nullptr;
+    const uint32_t* data = nullptr;
+    size_t size = 0;    // number of 32 bit data words, can be 0
+    bool swapData = false;  // data still in the byte order of the sender, see f_evt_lazy_swap(...)
+
+    /**
+     * @brief Return the i-th data word in the byte order of this machine.
+     */
+    uint32_t word(size_t i) const
+    {
+        uint32_t w = data[i];
+        if(swapData)
+            f_ut_swap4(&w, 1, nullptr);
+        return w;
+    }
+
+    /**
+     * @brief Copy the data into dest (size words) in the byte order of this machine.
+     */
+    void copyData(uint32_t* dest) const
+    {
+        if(swapData)
+            f_ut_swap4(const_cast<uint32_t*>(data), size, dest);
+        else if(size > 0)
+            std::memcpy(dest, data, size*sizeof(uint32_t));
+    }
+};
+
+/**
+ * @brief Range over the subevents of a raw MBS event of type 10/1, e.g. from f_evt_get_event(...).
+ *
+ * Each subevent is visited once, unlike calling f_evt_get_subevent(...) with 1, 2, 3, ...,
+ * which walks all previous subevents again.
+ * The range ends at the first subevent whose header or data does not fit into the event,
+ * complete() tells whether the subevents cover the event exactly.
+ * If the channel swaps lazily, pass ps_chan->l_evt_swap as swapData and read the data
+ * with word(...) or copyData(...), so that only the data that is used gets swapped.
+ *
+ * @example
+ *  for(const MbsSubevent& subevent : SubeventRange(event))
+ *      process(subevent.header->i_procid, subevent.data, subevent.size);
+ */
+class SubeventRange
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = MbsSubevent;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const MbsSubevent*;
+        using reference = const MbsSubevent&;
+
+        iterator() = default;
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+
+        iterator& operator++()
+        {
+            // lengths are in 16 bit words, the step is done in 32 bit words like in f_evt_get_subevent(...)
+            const int64_t words = current.header->l_dlen + 4;
+            next = reinterpret_cast<const INTS4*>(current.header) + words/2;
+            remaining -= words;
+            load();
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const { return current.header == other.current.header; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+        /**
+         * @brief Return true, if the range has ended at a subevent that does not fit into the event.
+         */
+        bool broken() const { return isBroken; }
+
+    private:
+        friend class SubeventRange;
+
+        iterator(const INTS4* first, int64_t remaining, bool swapData)
+            : next(first), remaining(remaining), swapData(swapData) { load(); }
+
+        void load()
+        {
+            current = MbsSubevent();
+            if(remaining == 0)
+                return;
+
+            // the header and the data must fit into the rest of the event
+            const s_ves10_1* header = reinterpret_cast<const s_ves10_1*>(next);
+            if(remaining < int64_t(sizeof(s_ves10_1)/2) || header->l_dlen < 2 || header->l_dlen + 4 > remaining)
+            {
+                isBroken = true;
+                return;
+            }
+
+            current.header = header;
+            current.data = reinterpret_cast<const uint32_t*>(header + 1);
+            current.size = header->l_dlen/2 - 1;
+            current.swapData = swapData;
+        }
+
+        const INTS4* next = nullptr;
+        int64_t remaining = 0;          // 16 bit words left in the event
+        bool isBroken = false;
+        bool swapData = false;
+        MbsSubevent current;
+    };
+
+    explicit SubeventRange(const s_ve10_1* event, bool swapData = false) : event(event), swapData(swapData) {}
+
+    iterator begin() const
+    {
+        if(event == nullptr)
+            return iterator();
+
+        // l_dlen counts the 16 bit words after i_subtype, 4 of them belong to the event header
+        return iterator(reinterpret_cast<const INTS4*>(event + 1), int64_t(event->l_dlen) - 4, swapData);
+    }
+
+    iterator end() const { return iterator(); }
+
+    /**
+     * @brief Return true, if the subevents cover the data of the event exactly. Walks the range.
+     */
+    bool complete() const
+    {
+        iterator it = begin();
+        while(it != end())
+            ++it;
+        return !it.broken();
+    }
+
+private:
+    const s_ve10_1* event;
+    bool swapData;
+};